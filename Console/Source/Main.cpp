@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Command line tools built around the plugin's processor. They live in their
+    own console target so none of this ships inside the plugin. Run from the
+    repository root:
+
+        super-autotune-console --regress
+
+    renders the golden signals through the processor, checks every one of
+    them against Console/Baselines/golden.json, checks the midi note and the
+    guide tone a few steady tones produce and exits with a non-zero code on
+    any regression.
+
+        super-autotune-console --replay <trace> [--profile=<file>]
+
+    feeds a trace captured by the plugin through a fresh processor and fails
+    when its output isn't bit exact with the capture, optionally writing the
+    processor's BlockProfiler counters for the replay as JSON.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RegressionHarness.h"
+#include "TraceReplay.h"
+
+namespace
+{
+    const char* const defaultBaselinePath = "Console/Baselines/golden.json";
+
+    void runRegression (const juce::ArgumentList& args)
+    {
+        const auto baselineFile = args.containsOption ("--baseline")
+                                    ? args.getFileForOption ("--baseline")
+                                    : juce::File::getCurrentWorkingDirectory().getChildFile (defaultBaselinePath);
+        const bool updateBaseline = args.containsOption ("--update-baseline");
+
+        if (! updateBaseline && ! baselineFile.existsAsFile())
+            juce::ConsoleApplication::fail ("No baseline at " + baselineFile.getFullPathName()
+                                              + ", run from the repository root or pass --baseline=<file>");
+
+        RegressionHarness harness;
+        harness.addDefaultSignals();
+
+        if (args.containsOption ("--fixtures"))
+            harness.addFixtures (args.getExistingFolderForOption ("--fixtures"));
+
+        if (updateBaseline)
+            baselineFile.getParentDirectory().createDirectory();
+
+        const auto results = harness.run (baselineFile, updateBaseline);
+        int numFailed = 0;
+
+        for (const auto& result : results)
+        {
+            std::cout << (result.passed() ? "PASS  " : "FAIL  ") << result.name
+                      << "  mean " << result.metrics.meanCentsError << " cents"
+                      << ", max " << result.metrics.maxCentsError << " cents"
+                      << ", flatness " << result.metrics.spectralFlatness
+                      << ", level " << result.metrics.levelDecibels << " dB"
+                      << ", cpu " << result.metrics.cpuPerSecond << " s/s"
+                      << " (" << result.metrics.cpuRatio << "x reference)" << std::endl;
+
+            for (const auto& failure : result.failures)
+                std::cout << "      " << failure << std::endl;
+
+            if (! result.passed())
+                ++numFailed;
+        }
+
+        if (args.containsOption ("--json"))
+            args.getFileForOption ("--json").replaceWithText (RegressionHarness::toJson (results));
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail (juce::String (numFailed) + " of " + juce::String (static_cast<int> (results.size()))
+                                              + (updateBaseline ? " signals failed, the baseline was not written"
+                                                                : " signals regressed"));
+
+        if (updateBaseline)
+            std::cout << "Baseline written to " << baselineFile.getFullPathName() << std::endl;
+    }
+
+    void runReplay (const juce::ArgumentList& args)
+    {
+        args.checkMinNumArguments (2);
+
+        TraceReplay replay;
+
+        if (! replay.load (args[1].resolveAsExistingFile()))
+            juce::ConsoleApplication::fail (replay.getError());
+
+        SuperautotuneAudioProcessor processor;
+        const auto hash = replay.run (processor);
+
+        std::cout << "Replayed " << replay.getNumBlocks() << " blocks, output hash "
+                  << juce::String::toHexString (static_cast<juce::int64> (hash)) << std::endl;
+        std::cout << replay.getNumCheckedBlocks() << " blocks checked against the capture" << std::endl;
+
+        if (replay.getNumDroppedBlocks() > 0)
+            std::cout << replay.getNumDroppedBlocks() << " blocks were dropped during the capture, "
+                         "nothing after the first one is checked" << std::endl;
+
+        //prepareToPlay clears the profiler, so this covers the trace from its last prepare record
+        if (args.containsOption ("--profile"))
+        {
+            const auto profileFile = args.getFileForOption ("--profile");
+
+            if (! profileFile.replaceWithText (processor.getProfiler().toJson()))
+                juce::ConsoleApplication::fail ("Can't write " + profileFile.getFullPathName());
+
+            std::cout << "Profile written to " << profileFile.getFullPathName() << std::endl;
+        }
+
+        if (replay.getError().isNotEmpty())
+            juce::ConsoleApplication::fail (replay.getError());
+
+        if (replay.getNumMismatchedBlocks() > 0)
+            juce::ConsoleApplication::fail (juce::String (replay.getNumMismatchedBlocks()) + " blocks differ from the capture, the first is block "
+                                              + juce::String (replay.getFirstMismatchedBlock()));
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    //the processor's parameter state and latency updates expect a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage:", true);
+
+    app.addCommand ({ "--regress",
+                      "--regress [--baseline=<file>] [--update-baseline] [--fixtures=<dir>] [--json=<file>]",
+                      "Checks the processor against the golden signal baseline.",
+                      "Renders the golden glides and vibrato notes, plus every wav in --fixtures, through the processor "
+                      "and compares mean and max pitch error, spectral flatness, level and cpu cost with the baseline, "
+                      + juce::String (defaultBaselinePath) + " by default. Cpu cost is measured as a multiple of a "
+                      "fixed fft workload timed in the same run, so the baseline holds across machines. A signal "
+                      "with no baseline entry or no cpu ratio fails, and so does any pitch error over a fixed limit "
+                      "whatever the baseline says. Steady tones on scale degrees are also checked for the midi note "
+                      "and the guide tone pitch they produce with either detector. "
+                      "--update-baseline rewrites the baseline from this run instead, only when every check passed. "
+                      "--json writes every metric and the profiler counters of the run.",
+                      runRegression });
+
+    app.addCommand ({ "--replay",
+                      "--replay <trace> [--profile=<file>]",
+                      "Replays a captured trace and checks the output is bit exact.",
+                      "Runs every block of a trace captured by the plugin through a fresh processor, with the "
+                      "same prepare calls, block sizes, parameter values and midi, starting from the engine "
+                      "state the capture started from, and compares each block's output with the hash recorded "
+                      "during the capture. Fails when any block differs. "
+                      "--profile writes the processor's per stage and per block timings of the replay as JSON.",
+                      runReplay });
+
+    return app.findAndRunCommand (argc, argv);
+}
@@ -0,0 +1,511 @@
+/*
+  ==============================================================================
+
+    RegressionHarness.cpp
+
+  ==============================================================================
+*/
+
+#include "RegressionHarness.h"
+#include "PluginProcessor.h"
+#include "Scale.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+RegressionHarness::RegressionHarness (double newSampleRate, int newBlockSize)
+    : sampleRate (newSampleRate), blockSize (newBlockSize)
+{
+}
+
+//==============================================================================
+void RegressionHarness::addDefaultSignals()
+{
+    addGlide ("glide_up", 150.0f, 600.0f, 3.0);
+    addGlide ("glide_down", 880.0f, 220.0f, 3.0);
+    addVibrato ("vibrato_a3", 220.0f, 5.5f, 50.0f, 3.0);
+    addVibrato ("vibrato_e4", 330.0f, 6.0f, 80.0f, 3.0);
+
+    //degrees of the 500 Hz five-limit scale, so the correction leaves them where they are
+    addNoteCheck ("note_125hz", 125.0f, 47);
+    addNoteCheck ("note_208hz", 625.0f / 3.0f, 56);
+    addNoteCheck ("note_250hz", 250.0f, 59);
+    addNoteCheck ("note_469hz", 468.75f, 70);
+}
+
+void RegressionHarness::addGlide (const juce::String& name, float startFrequency, float endFrequency, double seconds)
+{
+    Signal signal;
+    signal.name = name;
+
+    const int numSamples = static_cast<int> (seconds * sampleRate);
+    const double rate = sampleRate;
+    signal.inputPitchAt = [startFrequency, endFrequency, numSamples] (int i)
+    {
+        return startFrequency * std::pow (endFrequency / startFrequency, static_cast<float> (i) / static_cast<float> (numSamples));
+    };
+
+    signal.audio.setSize (1, numSamples);
+    auto* data = signal.audio.getWritePointer (0);
+    double phase = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        data[i] = 0.5f * static_cast<float> (std::sin (phase));
+        phase += juce::MathConstants<double>::twoPi * signal.inputPitchAt (i) / rate;
+    }
+
+    signals.push_back (std::move (signal));
+}
+
+void RegressionHarness::addVibrato (const juce::String& name, float centreFrequency, float rateHz, float depthCents, double seconds)
+{
+    Signal signal;
+    signal.name = name;
+
+    const int numSamples = static_cast<int> (seconds * sampleRate);
+    const double rate = sampleRate;
+    signal.inputPitchAt = [centreFrequency, rateHz, depthCents, rate] (int i)
+    {
+        float cents = depthCents * static_cast<float> (std::sin (juce::MathConstants<double>::twoPi * rateHz * i / rate));
+        return centreFrequency * std::pow (2.0f, cents / 1200.0f);
+    };
+
+    signal.audio.setSize (1, numSamples);
+    auto* data = signal.audio.getWritePointer (0);
+    double phase = 0.0;
+
+    //a few harmonics so the detector sees something voice-like
+    for (int i = 0; i < numSamples; ++i)
+    {
+        data[i] = static_cast<float> (0.4 * std::sin (phase) + 0.2 * std::sin (2.0 * phase) + 0.1 * std::sin (3.0 * phase));
+        phase += juce::MathConstants<double>::twoPi * signal.inputPitchAt (i) / rate;
+    }
+
+    signals.push_back (std::move (signal));
+}
+
+void RegressionHarness::addFixtures (const juce::File& directory)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    for (const auto& file : directory.findChildFiles (juce::File::findFiles, false, "*.wav"))
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader == nullptr)
+            continue;
+
+        //fixtures have to be recorded at the harness rate, resampling would hide detector changes
+        if (! juce::approximatelyEqual (reader->sampleRate, sampleRate))
+        {
+            DBG ("Skipping fixture with mismatched sample rate: " + file.getFullPathName());
+            continue;
+        }
+
+        Signal signal;
+        signal.name = file.getFileNameWithoutExtension();
+        signal.audio.setSize (1, static_cast<int> (reader->lengthInSamples));
+        reader->read (&signal.audio, 0, static_cast<int> (reader->lengthInSamples), 0, true, false);
+        signals.push_back (std::move (signal));
+    }
+}
+
+void RegressionHarness::addNoteCheck (const juce::String& name, float frequency, int expectedNote)
+{
+    noteChecks.push_back ({ name, frequency, expectedNote });
+}
+
+juce::AudioBuffer<float> RegressionHarness::makeTone (float frequency, double seconds) const
+{
+    const int numSamples = static_cast<int> (seconds * sampleRate);
+    juce::AudioBuffer<float> tone (1, numSamples);
+    auto* data = tone.getWritePointer (0);
+    const double increment = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double phase = increment * i;
+        data[i] = static_cast<float> (0.4 * std::sin (phase) + 0.2 * std::sin (2.0 * phase) + 0.1 * std::sin (3.0 * phase));
+    }
+
+    return tone;
+}
+
+//==============================================================================
+RegressionHarness::Rendering RegressionHarness::render (const juce::AudioBuffer<float>& input, const std::map<juce::String, float>& parameterValues)
+{
+    SuperautotuneAudioProcessor processor;
+
+    for (const auto& parameterValue : parameterValues)
+        if (auto* parameter = processor.parameters.getParameter (parameterValue.first))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (parameterValue.second));
+
+    processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    Rendering rendering;
+    rendering.latency = processor.getLatencySamples();
+
+    const int numSamples = input.getNumSamples();
+    auto& output = rendering.output;
+    output.setSize (2, numSamples);
+    juce::AudioBuffer<float> block (2, blockSize);
+    juce::MidiBuffer midi;
+
+    for (int start = 0; start + blockSize <= numSamples; start += blockSize)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            block.copyFrom (channel, 0, input, 0, start, blockSize);
+
+        midi.clear();
+
+        const auto ticks = juce::Time::getHighResolutionTicks();
+        processor.processBlock (block, midi);
+        rendering.processingSeconds += juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - ticks);
+
+        for (int channel = 0; channel < 2; ++channel)
+            output.copyFrom (channel, start, block, channel, 0, blockSize);
+
+        for (const auto metadata : midi)
+        {
+            const auto message = metadata.getMessage();
+
+            if (message.isNoteOn())
+                rendering.notesOn.add (message.getNoteNumber());
+        }
+    }
+
+    rendering.profile = processor.getProfiler().toVar();
+    processor.releaseResources();
+    return rendering;
+}
+
+RegressionHarness::Metrics RegressionHarness::measure (const Signal& signal)
+{
+    Metrics metrics;
+    const auto rendering = render (signal.audio);
+    const auto& output = rendering.output;
+    const int latency = rendering.latency;
+    metrics.profile = rendering.profile;
+
+    const int numSamples = signal.audio.getNumSamples();
+    metrics.cpuPerSecond = rendering.processingSeconds / (numSamples / sampleRate);
+    metrics.cpuRatio = referenceSeconds > 0.0 ? rendering.processingSeconds / referenceSeconds : 0.0;
+
+    //every channel is corrected, the first one also drives the midi output
+    const int channel = 0;
+    const float* in = signal.audio.getReadPointer (0);
+    const float* out = output.getReadPointer (channel);
+
+    Scale<float> scale (fiveLimitRatios<float>(), 500.0f);
+    float centsSum = 0.0f;
+    float flatnessSum = 0.0f;
+    int pitchedFrames = 0;
+    int frames = 0;
+
+    //the first output frame that has input behind it starts at the latency
+    for (int start = latency; start + analysisFrame <= numSamples; start += analysisHop)
+    {
+        ++frames;
+        flatnessSum += spectralFlatness (out + start, analysisFrame);
+
+        const int inputStart = start - latency;
+        float inputPitch = signal.inputPitchAt ? signal.inputPitchAt (inputStart + analysisFrame / 2)
+                                               : estimatePitch (in + inputStart, analysisFrame);
+        float outputPitch = estimatePitch (out + start, analysisFrame);
+
+        if (inputPitch <= 0.0f || outputPitch <= 0.0f)
+            continue;
+
+        float cents = std::abs (1200.0f * std::log2 (outputPitch / scale.findNote (inputPitch)));
+        centsSum += cents;
+        metrics.maxCentsError = juce::jmax (metrics.maxCentsError, cents);
+        ++pitchedFrames;
+    }
+
+    metrics.meanCentsError = pitchedFrames > 0 ? centsSum / static_cast<float> (pitchedFrames) : 0.0f;
+    metrics.spectralFlatness = frames > 0 ? flatnessSum / static_cast<float> (frames) : 0.0f;
+    metrics.levelDecibels = juce::Decibels::gainToDecibels (output.getRMSLevel (channel, latency, numSamples - latency));
+
+    return metrics;
+}
+
+RegressionHarness::Result RegressionHarness::checkNote (const NoteCheck& check)
+{
+    Result result;
+    result.name = check.name;
+
+    const auto tone = makeTone (check.frequency, noteCheckSeconds);
+    const int numSamples = tone.getNumSamples();
+
+    Scale<float> scale (fiveLimitRatios<float>(), 500.0f);
+    const float target = scale.findNote (check.frequency);
+    float centsSum = 0.0f;
+    int pitchedFrames = 0;
+
+    //switching detector mustn't move the note
+    for (int detector = 0; detector < 2; ++detector)
+    {
+        const auto detectorValue = static_cast<float> (detector);
+        const auto rendering = render (tone, { { "detector", detectorValue } });
+        const juce::String detectorName (detector == 0 ? "spectral peak" : "scale resonators");
+
+        if (rendering.notesOn.isEmpty())
+            result.failures.add (detectorName + " sent no note");
+
+        for (auto note : rendering.notesOn)
+        {
+            if (note != check.expectedNote)
+            {
+                result.failures.add (detectorName + " sent note " + juce::String (note) + ", expected " + juce::String (check.expectedNote));
+                break;
+            }
+        }
+
+        //the guide tone is added after everything else, so it's exactly what turning it up adds
+        auto guide = render (tone, { { "detector", detectorValue }, { "guide", 1.0f } }).output;
+        guide.addFrom (0, 0, rendering.output, 0, 0, numSamples, -1.0f);
+
+        const float* guideData = guide.getReadPointer (0);
+        const int pitchedBefore = pitchedFrames;
+
+        for (int start = rendering.latency; start + analysisFrame <= numSamples; start += analysisHop)
+        {
+            const float guidePitch = estimatePitch (guideData + start, analysisFrame);
+
+            if (guidePitch <= 0.0f)
+                continue;
+
+            const float cents = std::abs (1200.0f * std::log2 (guidePitch / target));
+            centsSum += cents;
+            result.metrics.maxCentsError = juce::jmax (result.metrics.maxCentsError, cents);
+            ++pitchedFrames;
+        }
+
+        if (pitchedFrames == pitchedBefore)
+            result.failures.add (detectorName + " played no guide tone");
+    }
+
+    result.metrics.meanCentsError = pitchedFrames > 0 ? centsSum / static_cast<float> (pitchedFrames) : 0.0f;
+
+    if (result.metrics.maxCentsError > tolerances.centsError)
+        result.failures.add ("guide tone " + juce::String (result.metrics.maxCentsError) + " cents off the note");
+
+    return result;
+}
+
+double RegressionHarness::measureReferenceSeconds() const
+{
+    juce::dsp::FFT fft (referenceOrder);
+    const size_t size = static_cast<size_t> (1 << referenceOrder);
+    std::vector<std::complex<float>> frame (size), spectrum (size);
+
+    for (size_t i = 0; i < size; ++i)
+        frame[i] = { static_cast<float> (std::sin (0.01 * static_cast<double> (i))), 0.0f };
+
+    double best = 0.0;
+
+    for (int attempt = 0; attempt < referenceRuns; ++attempt)
+    {
+        const auto ticks = juce::Time::getHighResolutionTicks();
+
+        //the inverse scales by 1 / size, so the frame comes back unchanged every time round
+        for (int i = 0; i < referenceTransforms; ++i)
+        {
+            fft.perform (frame.data(), spectrum.data(), false);
+            fft.perform (spectrum.data(), frame.data(), true);
+        }
+
+        const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - ticks);
+        best = attempt == 0 ? seconds : juce::jmin (best, seconds);
+    }
+
+    return best;
+}
+
+float RegressionHarness::estimatePitch (const float* data, int numSamples) const
+{
+    const int minLag = static_cast<int> (sampleRate / maxPitch);
+    const int maxLag = juce::jmin (static_cast<int> (sampleRate / minPitch), numSamples / 2);
+
+    float bestCorrelation = 0.0f;
+    int bestLag = 0;
+    std::vector<float> correlations (static_cast<size_t> (maxLag + 2), 0.0f);
+
+    //one past each end too, for the interpolation below
+    for (int lag = juce::jmax (1, minLag - 1); lag <= maxLag + 1; ++lag)
+    {
+        float correlation = 0.0f, energyA = 0.0f, energyB = 0.0f;
+
+        for (int i = 0; i + lag < numSamples; ++i)
+        {
+            correlation += data[i] * data[i + lag];
+            energyA += data[i] * data[i];
+            energyB += data[i + lag] * data[i + lag];
+        }
+
+        float normalised = correlation / (std::sqrt (energyA * energyB) + 1.0e-12f);
+        correlations[static_cast<size_t> (lag)] = normalised;
+
+        if (lag >= minLag && lag <= maxLag && normalised > bestCorrelation)
+        {
+            bestCorrelation = normalised;
+            bestLag = lag;
+        }
+    }
+
+    if (bestLag == 0 || bestCorrelation < minConfidence)
+        return 0.0f;
+
+    //a periodic frame correlates about as well at every multiple of its period, so the
+    //period is the first peak close to the best one rather than the best one itself
+    for (int lag = minLag; lag < bestLag; ++lag)
+    {
+        const auto index = static_cast<size_t> (lag);
+
+        if (correlations[index] >= periodThreshold * bestCorrelation
+             && correlations[index] >= correlations[index - 1] && correlations[index] >= correlations[index + 1])
+        {
+            bestLag = lag;
+            break;
+        }
+    }
+
+    //parabola through the peak and its neighbours, whole lags alone are several cents
+    //apart in the upper vocal range
+    const float peak = correlations[static_cast<size_t> (bestLag)];
+    const float before = correlations[static_cast<size_t> (bestLag - 1)];
+    const float after = correlations[static_cast<size_t> (bestLag + 1)];
+    const float curvature = before - 2.0f * peak + after;
+    const float offset = curvature < 0.0f ? 0.5f * (before - after) / curvature : 0.0f;
+
+    return static_cast<float> (sampleRate) / (static_cast<float> (bestLag) + juce::jlimit (-0.5f, 0.5f, offset));
+}
+
+float RegressionHarness::spectralFlatness (const float* data, int numSamples) const
+{
+    const int order = static_cast<int> (std::log2 (numSamples));
+    juce::dsp::FFT fft (order);
+    std::vector<float> spectrum (static_cast<size_t> (2 * (1 << order)), 0.0f);
+    std::copy (data, data + (1 << order), spectrum.begin());
+    fft.performFrequencyOnlyForwardTransform (spectrum.data());
+
+    const int numBins = (1 << order) / 2;
+    double logSum = 0.0, sum = 0.0;
+
+    for (int bin = 1; bin < numBins; ++bin)
+    {
+        double power = spectrum[bin] * spectrum[bin] + 1.0e-12;
+        logSum += std::log (power);
+        sum += power;
+    }
+
+    return static_cast<float> (std::exp (logSum / (numBins - 1)) / (sum / (numBins - 1)));
+}
+
+//==============================================================================
+std::vector<RegressionHarness::Result> RegressionHarness::run (const juce::File& baselineFile, bool updateBaseline)
+{
+    const juce::var baseline = baselineFile.existsAsFile() ? juce::JSON::parse (baselineFile) : juce::var();
+    std::vector<Result> results;
+
+    referenceSeconds = measureReferenceSeconds();
+
+    for (const auto& signal : signals)
+    {
+        Result result;
+        result.name = signal.name;
+        result.metrics = measure (signal);
+
+        const auto& m = result.metrics;
+
+        if (m.meanCentsError > limits.meanCentsError)
+            result.failures.add ("pitch error " + juce::String (m.meanCentsError) + " cents, over the "
+                                   + juce::String (limits.meanCentsError) + " cents limit");
+
+        if (m.maxCentsError > limits.maxCentsError)
+            result.failures.add ("max pitch error " + juce::String (m.maxCentsError) + " cents, over the "
+                                   + juce::String (limits.maxCentsError) + " cents limit");
+
+        const juce::var expected = baseline[juce::Identifier (signal.name)];
+
+        if (! updateBaseline && ! expected.isObject())
+        {
+            result.failures.add ("no baseline entry");
+        }
+        else if (! updateBaseline)
+        {
+            if (m.meanCentsError > static_cast<float> (expected["meanCentsError"]) + tolerances.centsError)
+                result.failures.add ("pitch error " + juce::String (m.meanCentsError) + " cents");
+
+            if (m.maxCentsError > static_cast<float> (expected["maxCentsError"]) + tolerances.maxCentsError)
+                result.failures.add ("max pitch error " + juce::String (m.maxCentsError) + " cents");
+
+            if (m.spectralFlatness > static_cast<float> (expected["spectralFlatness"]) + tolerances.spectralFlatness)
+                result.failures.add ("spectral flatness " + juce::String (m.spectralFlatness));
+
+            if (std::abs (m.levelDecibels - static_cast<float> (expected["levelDecibels"])) > tolerances.levelDecibels)
+                result.failures.add ("level " + juce::String (m.levelDecibels) + " dB");
+
+            //an entry without it would let any slowdown through
+            if (! expected.hasProperty ("cpuRatio"))
+                result.failures.add ("no cpu ratio in the baseline entry, rerun with --update-baseline");
+            else if (m.cpuRatio > static_cast<double> (expected["cpuRatio"]) * tolerances.cpuRatio)
+                result.failures.add ("cpu " + juce::String (m.cpuRatio) + " times the reference workload");
+        }
+
+        results.push_back (result);
+    }
+
+    for (const auto& check : noteChecks)
+        results.push_back (checkNote (check));
+
+    const bool allPassed = std::all_of (results.begin(), results.end(), [] (const Result& r) { return r.passed(); });
+
+    //the note checks are held to the scale, not to a baseline
+    if (updateBaseline && allPassed)
+        baselineFile.replaceWithText (toBaselineJson (std::vector<Result> (results.begin(), results.begin() + static_cast<std::ptrdiff_t> (signals.size()))));
+
+    return results;
+}
+
+juce::String RegressionHarness::toBaselineJson (const std::vector<Result>& results) const
+{
+    auto* root = new juce::DynamicObject();
+
+    for (const auto& result : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("meanCentsError", result.metrics.meanCentsError);
+        entry->setProperty ("maxCentsError", result.metrics.maxCentsError);
+        entry->setProperty ("spectralFlatness", result.metrics.spectralFlatness);
+        entry->setProperty ("levelDecibels", result.metrics.levelDecibels);
+        entry->setProperty ("cpuRatio", result.metrics.cpuRatio);
+
+        root->setProperty (juce::Identifier (result.name), juce::var (entry));
+    }
+
+    return juce::JSON::toString (juce::var (root));
+}
+
+juce::String RegressionHarness::toJson (const std::vector<Result>& results)
+{
+    auto* root = new juce::DynamicObject();
+
+    for (const auto& result : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("meanCentsError", result.metrics.meanCentsError);
+        entry->setProperty ("maxCentsError", result.metrics.maxCentsError);
+        entry->setProperty ("spectralFlatness", result.metrics.spectralFlatness);
+        entry->setProperty ("levelDecibels", result.metrics.levelDecibels);
+        entry->setProperty ("cpuPerSecond", result.metrics.cpuPerSecond);
+        entry->setProperty ("cpuRatio", result.metrics.cpuRatio);
+        entry->setProperty ("profile", result.metrics.profile);
+        root->setProperty (juce::Identifier (result.name), juce::var (entry));
+    }
+
+    return juce::JSON::toString (juce::var (root));
+}
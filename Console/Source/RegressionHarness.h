@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    RegressionHarness.h
+
+    Renders deterministic golden signals (glides, vibrato, and any recorded
+    voice fixtures) through the processor and measures pitch error against
+    the scale targets, artifacts and CPU cost, then compares the numbers with
+    a stored baseline so a change to the detector, the quantizer or the
+    shifter shows up as a regression.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <map>
+#include <vector>
+
+class RegressionHarness
+{
+public:
+    struct Metrics
+    {
+        float meanCentsError = 0.0f;
+        float maxCentsError = 0.0f;
+        float spectralFlatness = 0.0f;
+        float levelDecibels = 0.0f;
+        double cpuPerSecond = 0.0;  //seconds of processing per second of audio, informational only
+        double cpuRatio = 0.0;      //processing time over the reference workload's, what the baseline holds
+        juce::var profile;          //the processor's BlockProfiler counters, informational only
+    };
+
+    struct Result
+    {
+        juce::String name;
+        Metrics metrics;
+        juce::StringArray failures;
+
+        bool passed() const { return failures.isEmpty(); }
+    };
+
+    //how far a metric may drift from its baseline before it counts as a regression
+    struct Tolerances
+    {
+        float centsError = 5.0f;
+        float maxCentsError = 20.0f;
+        float spectralFlatness = 0.05f;
+        float levelDecibels = 1.5f;
+        double cpuRatio = 1.5;
+    };
+
+    //the most pitch error any signal may show whatever its baseline says, so a broken
+    //build fails, and can't be written in as the new baseline
+    struct Limits
+    {
+        float meanCentsError = 60.0f;
+        float maxCentsError = 400.0f;
+    };
+
+    explicit RegressionHarness (double sampleRate = 48000.0, int blockSize = 512);
+
+    Tolerances tolerances;
+    Limits limits;
+
+    //the standard golden set: glides across the vocal range and two vibrato notes
+    void addDefaultSignals();
+
+    //exponential glide between two frequencies
+    void addGlide (const juce::String& name, float startFrequency, float endFrequency, double seconds);
+
+    //sustained note with sinusoidal vibrato, depth in cents
+    void addVibrato (const juce::String& name, float centreFrequency, float rateHz, float depthCents, double seconds);
+
+    //every wav in the directory, its input pitch is estimated from the file itself
+    void addFixtures (const juce::File& directory);
+
+    //steady tone whose midi output has to be expectedNote with either detector, and whose
+    //guide tone has to sit on the scale note. It's checked against those rather than a
+    //baseline entry, its cents error is the guide tone's
+    void addNoteCheck (const juce::String& name, float frequency, int expectedNote);
+
+    //renders every signal, checks it against the limits and compares it against its
+    //baseline entry, a signal with no entry or an entry without a cpu ratio fails. With
+    //updateBaseline set the file is rewritten from the results instead, but only when
+    //every result, the note checks included, passed
+    std::vector<Result> run (const juce::File& baselineFile, bool updateBaseline);
+
+    //every metric of every result, including cpu and the profiler counters
+    static juce::String toJson (const std::vector<Result>& results);
+
+private:
+    struct Signal
+    {
+        juce::String name;
+        juce::AudioBuffer<float> audio;
+        std::function<float (int)> inputPitchAt;  //Hz at a sample index, empty for fixtures
+    };
+
+    struct NoteCheck
+    {
+        juce::String name;
+        float frequency;
+        int expectedNote;
+    };
+
+    struct Rendering
+    {
+        juce::AudioBuffer<float> output;
+        double processingSeconds = 0.0;
+        juce::var profile;
+        int latency = 0;            //the output is measured against the input this long before it
+        juce::Array<int> notesOn;   //every note the midi output started, in order
+    };
+
+    Metrics measure (const Signal& signal);
+
+    //seconds the reference workload takes on this machine, the best of a few runs. Cpu
+    //cost is stored as a multiple of it, so a baseline recorded on one machine holds on another
+    double measureReferenceSeconds() const;
+    Result checkNote (const NoteCheck& check);
+    juce::String toBaselineJson (const std::vector<Result>& results) const;
+    //parameterValues are set by parameter id, in their own units, before the processor is prepared
+    Rendering render (const juce::AudioBuffer<float>& input, const std::map<juce::String, float>& parameterValues = {});
+    //a few harmonics so the detector sees something voice-like
+    juce::AudioBuffer<float> makeTone (float frequency, double seconds) const;
+
+    //normalised autocorrelation pitch of a frame, 0 when the frame isn't periodic enough
+    float estimatePitch (const float* data, int numSamples) const;
+    float spectralFlatness (const float* data, int numSamples) const;
+
+    double sampleRate;
+    int blockSize;
+    std::vector<Signal> signals;
+    std::vector<NoteCheck> noteChecks;
+    double referenceSeconds = 0.0;
+
+    static constexpr int analysisFrame = 2048;
+    static constexpr int analysisHop = 512;
+    static constexpr float minPitch = 60.0f;
+    static constexpr float maxPitch = 1500.0f;
+    static constexpr float minConfidence = 0.8f;
+    static constexpr float periodThreshold = 0.9f;
+    static constexpr double noteCheckSeconds = 2.0;
+
+    //the reference workload: forward and inverse ffts of the size the engine uses for a low range
+    static constexpr int referenceOrder = 12;
+    static constexpr int referenceTransforms = 2000;
+    static constexpr int referenceRuns = 5;
+};
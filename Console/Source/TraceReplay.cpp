@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    TraceReplay.cpp
+
+  ==============================================================================
+*/
+
+#include "TraceReplay.h"
+#include "TraceRecorder.h"
+
+bool TraceReplay::load (const juce::File& file)
+{
+    trace.reset();
+    parameterIds.clear();
+    error = {};
+
+    if (! file.loadFileAsData (trace))
+    {
+        error = "can't read " + file.getFullPathName();
+        return false;
+    }
+
+    Reader reader { static_cast<const char*> (trace.getData()), trace.getSize() };
+
+    if (reader.read<uint32_t>() != TraceRecorder::magic)
+    {
+        error = "not a trace file";
+        return false;
+    }
+
+    //version 1 traces have no output hashes, they replay unchecked
+    traceVersion = reader.read<uint32_t>();
+
+    if (traceVersion < 1 || traceVersion > TraceRecorder::version)
+    {
+        error = "unsupported trace version";
+        return false;
+    }
+
+    const auto numParameters = reader.read<int32_t>();
+
+    for (int p = 0; p < numParameters; ++p)
+    {
+        const auto length = static_cast<size_t> (reader.read<int32_t>());
+
+        if (! reader.canRead (length))
+        {
+            error = "truncated parameter list";
+            return false;
+        }
+
+        parameterIds.add (juce::String::fromUTF8 (reader.data + reader.position, static_cast<int> (length)));
+        reader.position += length;
+    }
+
+    recordsStart = reader.position;
+    return true;
+}
+
+uint64_t TraceReplay::run (SuperautotuneAudioProcessor& processor)
+{
+    //the processor reads its parameters through the raw values, so the replay writes
+    //those directly, going through the normalised range could round differently
+    std::vector<std::atomic<float>*> parameterValues;
+    for (const auto& id : parameterIds)
+        parameterValues.push_back (processor.parameters.getRawParameterValue (id));
+
+    Reader reader { static_cast<const char*> (trace.getData()), trace.getSize(), recordsStart };
+    uint64_t hash = TraceRecorder::hashOffset;
+    uint64_t blockHash = 0;
+    bool doublePrecision = false;
+    bool prepared = false;
+    bool blockPending = false;
+    bool exact = true;
+
+    error = {};
+    numBlocks = 0;
+    numDroppedBlocks = 0;
+    numCheckedBlocks = 0;
+    numMismatchedBlocks = 0;
+    firstMismatchedBlock = -1;
+
+    while (reader.canRead (2 * sizeof (uint32_t)))
+    {
+        const auto type = reader.read<uint32_t>();
+        const auto payload = reader.read<uint32_t>();
+        const auto next = reader.position + payload;
+
+        //the tail of a capture that stopped mid-write
+        if (! reader.canRead (payload))
+            break;
+
+        if (type == TraceRecorder::prepareRecord)
+        {
+            const auto sampleRate = reader.read<double>();
+            const auto blockSize = reader.read<int32_t>();
+            const auto numChannels = reader.read<int32_t>();
+            doublePrecision = reader.read<int32_t>() != 0;
+            //older traces leave the orders to the replay's own range
+            const auto analysisOrder = payload >= TraceRecorder::preparePayload ? reader.read<int32_t>() : 0;
+
+            if (prepared)
+                processor.releaseResources();
+
+            processor.setProcessingPrecision (doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                              : juce::AudioProcessor::singlePrecision);
+            processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            //the range the replay prepared with may reach other orders than the capture's did
+            if (analysisOrder > 0)
+                processor.prepareAnalysisOrder (analysisOrder);
+
+            prepared = true;
+        }
+        else if (type == TraceRecorder::orderRecord && prepared)
+        {
+            processor.prepareAnalysisOrder (reader.read<int32_t>());
+        }
+        else if (type == TraceRecorder::stateRecord && prepared)
+        {
+            //the capture started on an engine that was already running
+            if (! processor.restoreEngineState (reader.data + reader.position, payload))
+            {
+                error = "the captured engine state doesn't match the replay's prepared engine";
+                exact = false;
+            }
+        }
+        else if (type == TraceRecorder::blockRecord && prepared)
+        {
+            const auto numSamples = reader.read<int32_t>();
+            const auto numChannels = reader.read<int32_t>();
+            const auto numParameters = reader.read<int32_t>();
+            const auto midiBytes = reader.read<int32_t>();
+
+            for (int p = 0; p < numParameters; ++p)
+            {
+                const auto value = reader.read<float>();
+                if (p < static_cast<int> (parameterValues.size()) && parameterValues[static_cast<size_t> (p)] != nullptr)
+                    parameterValues[static_cast<size_t> (p)]->store (value);
+            }
+
+            midi.clear();
+            const auto midiEnd = reader.position + static_cast<size_t> (midiBytes);
+
+            while (reader.position < midiEnd)
+            {
+                const auto samplePosition = reader.read<int32_t>();
+                const auto numBytes = reader.read<int32_t>();
+                midi.addEvent (reader.data + reader.position, numBytes, samplePosition);
+                reader.position += static_cast<size_t> (numBytes);
+            }
+
+            blockHash = doublePrecision ? processBlock (processor, reader, doubleBuffer, numSamples, numChannels)
+                                        : processBlock (processor, reader, floatBuffer, numSamples, numChannels);
+
+            TraceRecorder::hashBytes (hash, &blockHash, sizeof (blockHash));
+            blockPending = true;
+            ++numBlocks;
+        }
+        else if (type == TraceRecorder::outputRecord)
+        {
+            //the replay is no longer exact past a dropped block, so nothing is compared after one
+            if (blockPending && exact && numDroppedBlocks == 0)
+            {
+                ++numCheckedBlocks;
+
+                if (reader.read<uint64_t>() != blockHash)
+                {
+                    if (firstMismatchedBlock < 0)
+                        firstMismatchedBlock = numBlocks - 1;
+
+                    ++numMismatchedBlocks;
+                }
+            }
+
+            blockPending = false;
+        }
+        else if (type == TraceRecorder::droppedRecord)
+        {
+            //the replay is no longer exact past this point
+            numDroppedBlocks += static_cast<int> (reader.read<uint32_t>());
+        }
+
+        reader.position = next;
+    }
+
+    if (prepared)
+        processor.releaseResources();
+
+    return hash;
+}
+
+template <typename SampleType>
+uint64_t TraceReplay::processBlock (SuperautotuneAudioProcessor& processor, Reader& reader, juce::AudioBuffer<SampleType>& buffer,
+                                    int numSamples, int numChannels)
+{
+    buffer.setSize (numChannels, numSamples, false, false, true);
+
+    const auto channelBytes = static_cast<size_t> (numSamples) * sizeof (SampleType);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        std::memcpy (buffer.getWritePointer (channel), reader.data + reader.position, channelBytes);
+        reader.position += channelBytes;
+    }
+
+    processor.processBlock (buffer, midi);
+
+    //captures before the state record reset the engine and left the first block's midi
+    //out of its hash, see TraceRecorder
+    return TraceRecorder::hashOutput (buffer, midi, numBlocks > 0 || traceVersion >= 4);
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    TraceReplay.h
+
+    Feeds a TraceRecorder capture back through a fresh processor: the same
+    prepare calls, block sizes, raw parameter values, midi and input samples
+    the host sent, from the engine state the capture started on, so a
+    reported glitch can be reproduced and profiled under perf or valgrind.
+    Every block's output is checked against the hash the capture recorded
+    for it, so a replay that isn't bit exact is reported.
+    The whole trace is read up front, the replay loop does no file io.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <cstdint>
+
+class TraceReplay
+{
+public:
+    //reads and checks the trace header, false with getError() set on failure
+    bool load (const juce::File& file);
+
+    //set by load, or by run when the engine state the capture started from couldn't
+    //be restored, nothing is checked against the capture then
+
+    const juce::String& getError() const { return error; }
+
+    //runs every record through the processor in capture order and returns a hash
+    //of all the output it produced, two replays of one trace must give the same hash
+    uint64_t run (SuperautotuneAudioProcessor& processor);
+
+    int getNumBlocks() const         { return numBlocks; }
+    int getNumDroppedBlocks() const  { return numDroppedBlocks; }
+
+    //blocks compared with the output the capture recorded, and those that differed.
+    //Blocks past a dropped one, and those whose hash didn't fit the ring, go unchecked
+    int getNumCheckedBlocks() const     { return numCheckedBlocks; }
+    int getNumMismatchedBlocks() const  { return numMismatchedBlocks; }
+
+    //index of the first block that differed, -1 when none did
+    int getFirstMismatchedBlock() const { return firstMismatchedBlock; }
+
+private:
+    struct Reader
+    {
+        const char* data;
+        size_t size;
+        size_t position = 0;
+
+        bool canRead (size_t numBytes) const { return position + numBytes <= size; }
+
+        template <typename Type>
+        Type read()
+        {
+            Type value {};
+            if (canRead (sizeof (Type)))
+                std::memcpy (&value, data + position, sizeof (Type));
+            position += sizeof (Type);
+            return value;
+        }
+    };
+
+    //returns the TraceRecorder::hashOutput of the processed block
+    template <typename SampleType>
+    uint64_t processBlock (SuperautotuneAudioProcessor& processor, Reader& reader, juce::AudioBuffer<SampleType>& buffer,
+                           int numSamples, int numChannels);
+
+    juce::MemoryBlock trace;
+    size_t recordsStart = 0;
+    uint32_t traceVersion = 0;
+    juce::StringArray parameterIds;
+    juce::String error;
+
+    int numBlocks = 0;
+    int numDroppedBlocks = 0;
+    int numCheckedBlocks = 0;
+    int numMismatchedBlocks = 0;
+    int firstMismatchedBlock = -1;
+
+    juce::AudioBuffer<float> floatBuffer;
+    juce::AudioBuffer<double> doubleBuffer;
+    juce::MidiBuffer midi;
+};
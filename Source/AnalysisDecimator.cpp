@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    AnalysisDecimator.cpp
+
+  ==============================================================================
+*/
+
+#include "AnalysisDecimator.h"
+#include <cmath>
+
+void AnalysisDecimator::prepare (double sampleRate, int maximumBlockSize)
+{
+    //windowed sinc half-band, every even tap away from the centre is zero
+    coefficients.clear();
+    float sum = 0.5f;
+
+    for (int offset = 1; offset <= centreTap; offset += 2)
+    {
+        const double x = juce::MathConstants<double>::pi * offset / (centreTap + 1);
+        const double blackman = 0.42 + 0.5 * std::cos (x) + 0.08 * std::cos (2.0 * x);
+        const double sinc = std::sin (juce::MathConstants<double>::halfPi * offset) / (juce::MathConstants<double>::pi * offset);
+        coefficients.push_back (static_cast<float> (sinc * blackman));
+        sum += 2.0f * coefficients.back();
+    }
+
+    //unity gain at dc
+    for (auto& c : coefficients)
+        c /= sum;
+    coefficients.insert (coefficients.begin(), 0.5f / sum);
+
+    int numStages = 0;
+    analysisRate = sampleRate;
+
+    while (analysisRate > maxAnalysisRate)
+    {
+        analysisRate /= 2.0;
+        ++numStages;
+    }
+
+    stages.resize (static_cast<size_t> (numStages));
+
+    for (auto& stage : stages)
+        stage.history.assign (2 * numTaps, 0.0f);
+
+    input.resize (static_cast<size_t> (juce::jmax (maximumBlockSize, 1)));
+    reset();
+}
+
+void AnalysisDecimator::reset()
+{
+    for (auto& stage : stages)
+    {
+        std::fill (stage.history.begin(), stage.history.end(), 0.0f);
+        stage.writePosition = 0;
+        stage.skipNext = false;
+    }
+}
+
+int AnalysisDecimator::Stage::process (float* data, int numSamples, const std::vector<float>& coefficients)
+{
+    const float centre = coefficients[0];
+    const int numOdd = static_cast<int> (coefficients.size()) - 1;
+    int numOutputs = 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        history[static_cast<size_t> (writePosition)] = data[i];
+        history[static_cast<size_t> (writePosition + numTaps)] = data[i];
+        writePosition = (writePosition + 1) % numTaps;
+
+        skipNext = ! skipNext;
+        if (! skipNext)
+            continue;
+
+        //oldest sample of the window first, the filter is symmetric around the centre
+        const float* window = history.data() + writePosition;
+        float out = centre * window[centreTap];
+
+        for (int k = 0; k < numOdd; ++k)
+        {
+            const int offset = 2 * k + 1;
+            out += coefficients[static_cast<size_t> (k + 1)] * (window[centreTap - offset] + window[centreTap + offset]);
+        }
+
+        data[numOutputs++] = out;
+    }
+
+    return numOutputs;
+}
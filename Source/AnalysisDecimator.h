@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    AnalysisDecimator.h
+
+    Cascade of polyphase half-band decimators that brings the input down to
+    8 - 16 kHz for pitch detection. Vocal fundamentals sit well below the
+    decimated nyquist, so the detector sees the same pitch while running at
+    a rate that no longer follows the host sample rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+class AnalysisDecimator
+{
+public:
+    //picks enough stages to get sampleRate down to maxAnalysisRate and sizes the
+    //output for maximumBlockSize input samples
+    void prepare (double sampleRate, int maximumBlockSize);
+    void reset();
+
+    //every stage's delay line, see StateArchive.h. The stages come from prepare
+    template <typename Archive>
+    void visitState (Archive& archive)
+    {
+        auto numStages = static_cast<uint32_t> (stages.size());
+        archive.value (numStages);
+        archive.check (numStages == stages.size());
+
+        if (! archive.isValid())
+            return;
+
+        for (auto& stage : stages)
+        {
+            archive.vector (stage.history);
+            archive.value (stage.writePosition);
+            archive.value (stage.skipNext);
+            archive.check (stage.history.size() == static_cast<size_t> (2 * numTaps));
+        }
+    }
+
+    //decimates a block, returns the number of samples written to getOutput()
+    template <typename SampleType>
+    int process (const SampleType* data, int numSamples)
+    {
+        if (stages.empty())
+            return 0;
+
+        jassert (numSamples <= static_cast<int> (input.size()));
+        numSamples = juce::jmin (numSamples, static_cast<int> (input.size()));
+
+        for (int i = 0; i < numSamples; ++i)
+            input[static_cast<size_t> (i)] = static_cast<float> (data[i]);
+
+        //every stage halves the block in place
+        for (auto& stage : stages)
+            numSamples = stage.process (input.data(), numSamples, coefficients);
+
+        return numSamples;
+    }
+
+    const float* getOutput() const  { return input.data(); }
+
+    //1 when the host rate is already low enough, then the decimator is bypassed
+    int getFactor() const           { return 1 << static_cast<int> (stages.size()); }
+    double getAnalysisRate() const  { return analysisRate; }
+
+    static constexpr double maxAnalysisRate = 16000.0;
+
+private:
+    struct Stage
+    {
+        //filters and keeps every second sample, only the non-zero odd taps and the
+        //centre tap are evaluated, writes the output over the front of data
+        int process (float* data, int numSamples, const std::vector<float>& coefficients);
+
+        //doubled delay line, so a full window is always contiguous
+        std::vector<float> history;
+        int writePosition = 0;
+        bool skipNext = false;
+    };
+
+    //half-band length, 4k + 3 taps so the outermost taps are non-zero
+    static constexpr int numTaps = 23;
+    static constexpr int centreTap = numTaps / 2;
+
+    //coefficients of the odd taps either side of the centre, nearest first
+    std::vector<float> coefficients;
+    std::vector<Stage> stages;
+    std::vector<float> input;
+    double analysisRate = 44100.0;
+};
@@ -0,0 +1,681 @@
+/*
+  ==============================================================================
+
+    AutotuneEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "AutotuneEngine.h"
+#include <cmath>
+
+//==============================================================================
+template <typename SampleType>
+AutotuneEngine<SampleType>::AutotuneEngine()
+    : sincKernel (SharedTables::getSincKernel()),
+      _5lim_500hz(fiveLimitRatios<SampleType>(), SampleType(500))
+{
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::prepare (double newSampleRate, int maximumBlockSize, int numChannels)
+{
+    juce::ignoreUnused (maximumBlockSize);
+    sampleRate = newSampleRate;
+
+    //chunks are gathered across host blocks, so the longest one is set by the
+    //lowest frequency any range can ask for, not by the block size
+    const int maxOrder = juce::jlimit (minOrder, maxSupportedOrder, orderForSamples (analysisSamplesFor (lowestFrequency)));
+    maxAnalysisSamples = 1 << (maxOrder - 1);
+
+    bankNotes.reserve (static_cast<size_t> (maxResonators));
+    tunedSampleRate = 0.0;
+    preparedOrder = 0;
+    order = 0;
+    //a fresh set of channels, so the orders a previous range built are let go
+    channels.clear();
+    setNumChannels (numChannels);
+
+    //only the orders up to the current range's are built, each one is about as big
+    //as all the smaller ones together, and a 20 Hz range needs 14 at 48 kHz
+    requestedOrder.store (0);
+    prepareOrder (orderForSamples (getAnalysisSamples()));
+    detectionRate = channels.front().decimator.getAnalysisRate();
+
+    analysisSamples = getAnalysisSamples();
+    setOrder (orderForSamples (analysisSamples));
+    selectKernel();
+    reset();
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::prepareOrder (int newOrder)
+{
+    preparedOrder = juce::jlimit (minOrder, orderForSamples (maxAnalysisSamples), newOrder);
+
+    if (requestedOrder.load() <= preparedOrder)
+        requestedOrder.store (0);
+
+    for (auto& state : channels)
+        prepareFFTs (state);
+
+    //size the scratch for the longest order, so switching down to a shorter one on
+    //the audio thread never reallocates
+    const int currentOrder = order;
+    setOrder (preparedOrder);
+    setOrder (currentOrder);
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::reset()
+{
+    for (auto& state : channels)
+    {
+        state.formants.reset();
+        state.decimator.reset();
+        state.resonators.reset();
+        state.guideTone.reset();
+        state.lastFrameClass = FrameClass::voiced;
+        state.lastOutput = 0;
+        state.lastNote = 0.0f;
+        state.chunkPosition = 0;
+        std::fill (state.outputChunk.begin(), state.outputChunk.end(), SampleType (0));
+    }
+
+    midiOutput.reset();
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::setOrder (int newOrder)
+{
+    jassert (preparedOrder >= minOrder);
+    newOrder = juce::jlimit (minOrder, preparedOrder, newOrder);
+
+    if (newOrder == order)
+        return;
+
+    order = newOrder;
+    processChannelsFunction = nullptr;
+
+    for (auto& state : channels)
+        prepareChannel (state);
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::setNumChannels (int numChannels)
+{
+    const size_t newSize = static_cast<size_t> (juce::jmax (numChannels, 1));
+
+    if (newSize == channels.size())
+        return;
+
+    channels.resize (newSize);
+
+    for (auto& state : channels)
+    {
+        state.guideTone.prepare (sampleRate);
+        state.resonators.prepare (maxResonators);
+        state.chunkPosition = 0;
+    }
+    tunedSampleRate = 0.0;
+
+    if (preparedOrder > 0)
+    {
+        for (auto& state : channels)
+            prepareFFTs (state);
+    }
+
+    if (order > 0)
+    {
+        for (auto& state : channels)
+            prepareChannel (state);
+    }
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::prepareFFTs (ChannelState& state)
+{
+    for (int o = minOrder; o <= preparedOrder; ++o)
+        if (state.ffts[static_cast<size_t> (o)] == nullptr)
+            state.ffts[static_cast<size_t> (o)] = std::make_unique<juce::dsp::FFT> (o);
+
+    //chunks only ever grow, the gathered samples survive a range that comes back up
+    const auto preparedSamples = static_cast<size_t> (getPreparedSamples());
+
+    if (state.inputChunk.size() < preparedSamples)
+    {
+        state.inputChunk.resize (preparedSamples, SampleType (0));
+        state.outputChunk.resize (preparedSamples, SampleType (0));
+        state.decimator.prepare (sampleRate, getPreparedSamples());
+    }
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::prepareChannel (ChannelState& state)
+{
+    state.fft = state.ffts[static_cast<size_t> (order)].get();
+    jassert (state.fft != nullptr);
+
+    const size_t size = static_cast<size_t> (1 << order);
+
+    if (state.fft_in.size() == size)
+        return;
+
+    state.fft_in.assign (size, { 0.0f, 0.0f });
+    state.fft_out.assign (size, { 0.0f, 0.0f });
+    state.shifted_bins.assign (size, { 0.0f, 0.0f });
+    state.voice_bins.assign (size, { 0.0f, 0.0f });
+    state.phases.assign (size, 0.0f);
+    state.formants.prepare (1 << order);
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::process (juce::AudioBuffer<SampleType>& buffer, int totalNumInputChannels, int totalNumOutputChannels)
+{
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    if (buffer.getNumChannels() == 0 || buffer.getNumSamples() == 0)
+        return;
+
+    setNumChannels (totalNumInputChannels);
+
+    //a new range changes the chunk length and with it the latency, whatever was
+    //gathered for the old length is dropped. One that needs a longer chunk than
+    //prepared waits on the longest prepared one until its ffts are built
+    const int rangeSamples = getAnalysisSamples();
+    const int newAnalysisSamples = juce::jmin (rangeSamples, getPreparedSamples());
+
+    if (rangeSamples > newAnalysisSamples)
+        requestedOrder.store (orderForSamples (rangeSamples));
+    else if (requestedOrder.load() != 0)
+        requestedOrder.store (0);
+
+    if (newAnalysisSamples != analysisSamples)
+    {
+        analysisSamples = newAnalysisSamples;
+        setOrder (orderForSamples (analysisSamples));
+
+        for (auto& state : channels)
+        {
+            state.chunkPosition = 0;
+            std::fill (state.outputChunk.begin(), state.outputChunk.end(), SampleType (0));
+        }
+    }
+
+    if (detector == Detector::resonatorBank)
+        tuneResonators();
+
+    if (processChannelsFunction == nullptr)
+        selectKernel();
+
+    (this->*processChannelsFunction) (buffer, totalNumInputChannels);
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::writeMidi (juce::MidiBuffer& midi)
+{
+    if (! midiOutputEnabled)
+        midiOutput.release (0);
+
+    midiOutput.writeTo (midi);
+}
+
+//==============================================================================
+template <typename SampleType>
+void AutotuneEngine<SampleType>::setRange (float newMinFrequency, float newMaxFrequency)
+{
+    minFrequency = juce::jmax (lowestFrequency, juce::jmin (newMinFrequency, newMaxFrequency));
+    maxFrequency = juce::jmax (minFrequency + 1.0f, newMaxFrequency);
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::tuneResonators()
+{
+    if (minFrequency == tunedMinFrequency && maxFrequency == tunedMaxFrequency && detectionRate == tunedSampleRate)
+        return;
+
+    _5lim_500hz.notesInRange (static_cast<SampleType> (minFrequency), static_cast<SampleType> (maxFrequency), bankNotes, maxResonators);
+
+    for (auto& state : channels)
+        state.resonators.setFrequencies (bankNotes.data(), static_cast<int> (bankNotes.size()), detectionRate);
+
+    tunedMinFrequency = minFrequency;
+    tunedMaxFrequency = maxFrequency;
+    tunedSampleRate = detectionRate;
+}
+
+template <typename SampleType>
+int AutotuneEngine<SampleType>::analysisSamplesFor (float frequency) const
+{
+    return juce::nextPowerOfTwo (static_cast<int> (std::ceil (periodsPerAnalysis * sampleRate / frequency)));
+}
+
+template <typename SampleType>
+int AutotuneEngine<SampleType>::getAnalysisSamples() const
+{
+    return juce::jmin (analysisSamplesFor (minFrequency), maxAnalysisSamples);
+}
+
+template <typename SampleType>
+int AutotuneEngine<SampleType>::orderForSamples (int numSamples)
+{
+    return 1 + static_cast<int> (std::ceil (std::log2 (juce::jmax (numSamples, 1))));
+}
+
+//==============================================================================
+template <typename SampleType>
+typename AutotuneEngine<SampleType>::FrameClass AutotuneEngine<SampleType>::classifyFrame (const SampleType* data, int numSamples) const
+{
+    SampleType sumOfSquares = 0;
+    int crossings = 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        sumOfSquares += data[i] * data[i];
+
+        if (i > 0 && (data[i - 1] < 0) != (data[i] < 0))
+            ++crossings;
+    }
+
+    const SampleType rms = std::sqrt (sumOfSquares / static_cast<SampleType> (numSamples));
+
+    if (juce::Decibels::gainToDecibels (static_cast<float> (rms), -120.0f) < silenceThresholdDb)
+        return FrameClass::silent;
+
+    //breaths and sibilants are noise-like and cross zero far more often than a voiced fundamental
+    if (static_cast<float> (crossings) / static_cast<float> (numSamples) > unvoicedCrossingRate)
+        return FrameClass::unvoiced;
+
+    return FrameClass::voiced;
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::passThrough (ChannelState& state, SampleType* channelData, int numSamples, bool wasCorrected)
+{
+    if (wasCorrected)
+        smoothTransition (channelData, numSamples, state.lastOutput);
+
+    state.lastOutput = channelData[numSamples - 1];
+    state.lastNote = 0.0f;
+
+    //no pitch to follow, the guide tone fades out
+    state.guideTone.process (channelData, numSamples, 0.0f, 0.0f);
+}
+
+template <typename SampleType>
+void AutotuneEngine<SampleType>::smoothTransition (SampleType* data, int numSamples, SampleType previousSample)
+{
+    //decays the step between the last sample of the previous path and the first of this one
+    const SampleType step = previousSample - data[0];
+    const int rampLength = juce::jmin (numSamples, transitionSamples);
+
+    for (int i = 0; i < rampLength; ++i)
+        data[i] += step * (SampleType(1) - static_cast<SampleType> (i) / static_cast<SampleType> (rampLength));
+}
+
+//==============================================================================
+template <typename SampleType>
+void AutotuneEngine<SampleType>::selectKernel()
+{
+    switch (1 << order)
+    {
+        case 256:  processChannelsFunction = &AutotuneEngine::processChannels<256>;  break;
+        case 512:  processChannelsFunction = &AutotuneEngine::processChannels<512>;  break;
+        case 1024: processChannelsFunction = &AutotuneEngine::processChannels<1024>; break;
+        case 2048: processChannelsFunction = &AutotuneEngine::processChannels<2048>; break;
+        default:   processChannelsFunction = &AutotuneEngine::processChannels<0>;    break;
+    }
+}
+
+template <typename SampleType>
+template <int FrameSize>
+void AutotuneEngine<SampleType>::processChannels (juce::AudioBuffer<SampleType>& buffer, int numChannels)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    //immersive layouts: one task per channel, the audio thread takes a share too
+    if (workerPool != nullptr && numChannels > 2)
+    {
+        ChannelJob job { this, &buffer };
+        workerPool->run (numChannels, &AutotuneEngine::processChannelTask<FrameSize>, &job);
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelData = buffer.getWritePointer(channel);
+
+        if (channelData == nullptr) {
+            DBG("Error: channelData pointer is null!");
+            return;
+        }
+
+        processChannelChunks<FrameSize> (channel, channelData, numSamples);
+    }
+}
+
+template <typename SampleType>
+template <int FrameSize>
+void AutotuneEngine<SampleType>::processChannelChunks (int channel, SampleType* channelData, int numSamples)
+{
+    auto& state = channels[static_cast<size_t> (channel)];
+
+    //midi follows the first input channel, so a mono vocal track drives it
+    const bool midiChannel = midiOutputEnabled && channel == midiSourceChannel;
+
+    //the channel runs analysisSamples late: every input sample goes into the chunk
+    //being gathered while the corrected sample from the previous chunk comes out,
+    //so the chunk length follows the range whatever the host block size is
+    for (int start = 0; start < numSamples;)
+    {
+        const int count = juce::jmin (numSamples - start, analysisSamples - state.chunkPosition);
+        auto* gathered = state.inputChunk.data() + state.chunkPosition;
+        const auto* corrected = state.outputChunk.data() + state.chunkPosition;
+
+        for (int i = 0; i < count; ++i)
+        {
+            gathered[i] = channelData[start + i];
+            channelData[start + i] = corrected[i];
+        }
+
+        start += count;
+        state.chunkPosition += count;
+
+        if (state.chunkPosition < analysisSamples)
+            continue;
+
+        //the full chunk becomes the next output and is corrected in place
+        state.chunkPosition = 0;
+        std::swap (state.inputChunk, state.outputChunk);
+
+        auto* chunk = state.outputChunk.data();
+        const float level = midiChannel ? PitchToMidi::getRms (chunk, analysisSamples) : 0.0f;
+
+        processChannel<FrameSize> (channel, chunk, analysisSamples);
+
+        //notes start where the corrected chunk starts playing, a chunk that starts
+        //with the next block is stamped on this block's last sample
+        if (midiChannel)
+            midiOutput.addFrame (juce::jmin (start, numSamples - 1), state.lastNote, level);
+    }
+}
+
+template <typename SampleType>
+template <int FrameSize>
+void AutotuneEngine<SampleType>::processChannelTask (void* context, int taskIndex)
+{
+    auto& job = *static_cast<ChannelJob*> (context);
+    const int channel = taskIndex;
+
+    if (auto* channelData = job.buffer->getWritePointer (channel))
+        job.engine->template processChannelChunks<FrameSize> (channel, channelData, job.buffer->getNumSamples());
+}
+
+template <typename SampleType>
+template <int FrameSize>
+void AutotuneEngine<SampleType>::processChannel (int channel, SampleType* channelData, int numSamples)
+{
+    auto& state = channels[static_cast<size_t> (channel)];
+    auto& fft_in = state.fft_in;
+    auto& fft_out = state.fft_out;
+    auto& shifted_bins = state.shifted_bins;
+    auto& voice_bins = state.voice_bins;
+    auto& phases = state.phases;
+
+    //a fixed frame size gives the bin loops a constant trip count
+    const int frameSize = FrameSize > 0 ? FrameSize : static_cast<int> (fft_out.size());
+    jassert (frameSize == static_cast<int> (fft_out.size()));
+
+    const float sampleRateF = static_cast<float> (sampleRate);
+
+    //cheap time domain gate: silent and unvoiced frames skip the fft work and pass through dry
+    const FrameClass frameClass = gateEnabled ? classifyFrame (channelData, numSamples) : FrameClass::voiced;
+    const bool wasCorrected = state.lastFrameClass == FrameClass::voiced;
+    state.lastFrameClass = frameClass;
+
+    if (frameClass != FrameClass::voiced)
+    {
+        passThrough (state, channelData, numSamples, wasCorrected);
+        return;
+    }
+
+    jassert (numSamples <= frameSize);
+
+    BlockProfiler::Lap lap (profiler);
+
+    //copy the block into the zero padded fft frame
+    std::fill (fft_in.begin(), fft_in.end(), std::complex<float> { 0.0f, 0.0f });
+    std::fill (phases.begin(), phases.end(), 0.0f);
+
+    for (int i = 0; i < numSamples; ++i) {
+        fft_in[i] = std::complex<float>(static_cast<float> (channelData[i]), 0.0f);
+    }
+
+
+    //fill output with bins
+    state.fft->perform(fft_in.data(), fft_out.data(), false);
+
+    float frequency = 0.0f;
+
+    if (detector == Detector::resonatorBank)
+    {
+        //resonators run every sample but pick the note once per chunk, the fft is only needed for the shift
+        if (state.decimator.getFactor() > 1)
+        {
+            const int numDecimated = state.decimator.process (channelData, numSamples);
+            if (numDecimated > 0)
+                state.resonators.process (state.decimator.getOutput(), numDecimated);
+        }
+        else
+        {
+            state.resonators.process (channelData, numSamples);
+        }
+        //0 on quiet frames and onsets the resonators haven't rung up to yet,
+        //which takes the unpitched path below
+        frequency = state.resonators.getFrequency();
+    }
+    else
+    {
+        //get bin with max magnitude
+
+        //squared magnitudes pick the same bin without a hypot per bin
+        float maxMagnitude = 0.0f;
+        int maxBin = -1;
+        //search only the bins of the voice range, bin = frequency * frameSize / sampleRate
+        int minBinIndex = static_cast<int>((minFrequency / sampleRateF) * frameSize);
+        int maxBinIndex = juce::jmin (frameSize / 2, static_cast<int>((maxFrequency / sampleRateF) * frameSize));
+
+        for (int i = minBinIndex; i < maxBinIndex; ++i)
+        {
+            if (std::norm(fft_out[i]) > maxMagnitude)
+            {
+                maxMagnitude = std::norm(fft_out[i]);
+                maxBin = i;
+            }
+        }
+
+        //bins are sampleRate / frameSize apart whatever the zero padding, so this is
+        //the pitch in Hz the quantizer, the midi output and the guide tone expect
+        frequency = (maxBin * sampleRateF) / frameSize;
+    }
+
+    //idk why but sometimes frequency is negative on startup
+    if(frequency < 0){
+        frequency = 0;
+    }
+
+    lap.mark (BlockProfiler::detect);
+
+    //map to scale
+    SampleType newFrequency = 0;
+    if (frequency > 0)
+        newFrequency = detector == Detector::resonatorBank ? static_cast<SampleType> (state.resonators.getNote())
+                                                           : _5lim_500hz.findNote(static_cast<SampleType> (frequency));
+
+    lap.mark (BlockProfiler::quantize);
+
+    //no pitch in a frame the gate let through (digital silence with the gate off, a
+    //quiet frame, an onset the resonators haven't caught yet): there's nothing to
+    //correct to and the ratio would be 0 / 0, so the frame goes through dry
+    if (frequency <= 0 || newFrequency <= 0)
+    {
+        state.lastFrameClass = FrameClass::unpitched;
+        passThrough (state, channelData, numSamples, wasCorrected);
+        return;
+    }
+
+    float correctionRatio = static_cast<float> (newFrequency / static_cast<SampleType> (frequency));
+    //correctionRatio = 1;
+    state.lastNote = static_cast<float> (newFrequency);
+
+    //spectral envelope from the same frame, reused while the pitch holds still, it
+    //only serves the shift so it's charged there
+    FormantEnvelope* formants = nullptr;
+    if (preserveFormants)
+    {
+        formants = &state.formants;
+        formants->update (*state.fft, fft_out.data(), frequency, sampleRateF);
+    }
+
+    //clear the buffer
+    std::fill(channelData, channelData + numSamples, SampleType(0));
+
+    //change pitch
+    std::fill (shifted_bins.begin(), shifted_bins.end(), std::complex<float> { 0.0f, 0.0f });
+
+    remapBins<FrameSize> (state, correctionRatio, formants, shifted_bins.data(), numSamples);
+
+    //harmonizer: every extra voice is remapped from the same spectrum and summed,
+    //so detection, the forward fft and the envelope are shared and all voices
+    //go through a single inverse transform
+    const int numVoices = juce::jlimit (0, maxHarmonyVoices, numHarmonyVoices);
+
+    for (int voice = 0; voice < numVoices; ++voice)
+    {
+        SampleType harmonyFrequency = _5lim_500hz.findHarmony(static_cast<SampleType> (frequency), harmonyDegrees[static_cast<size_t> (voice)]);
+        float harmonyRatio = static_cast<float> (harmonyFrequency / static_cast<SampleType> (frequency));
+
+        std::fill (voice_bins.begin(), voice_bins.end(), std::complex<float> { 0.0f, 0.0f });
+        remapBins<FrameSize> (state, harmonyRatio, formants, voice_bins.data(), numSamples);
+
+        for (int bin = 0; bin < frameSize; ++bin)
+            shifted_bins[bin] += voice_bins[bin] * harmonyVoiceGain;
+    }
+    //shifted_bins = fft_out;
+
+    //dc has no negative twin, so it's halved before the real part is doubled
+    shifted_bins[0] *= 0.5f;
+
+    lap.mark (BlockProfiler::shift);
+
+    //back to the time domain. Only the positive half of the spectrum is filled, so the
+    //real part is half the shifted signal, the magnitude would be its envelope
+    state.fft->perform(shifted_bins.data(), fft_out.data(), true);
+
+    for (int i = 0; i < numSamples; ++i) 
+    {
+        channelData[i] = static_cast<SampleType> (2.0f * fft_out[i].real());
+    }
+
+    if (! wasCorrected)
+        smoothTransition (channelData, numSamples, state.lastOutput);
+
+    state.lastOutput = channelData[numSamples - 1];
+
+    //guide tone on the corrected pitch, added after the path smoothing which only
+    //needs to hide steps in the corrected signal
+    state.guideTone.setNumPartials (guideToneHarmonics);
+    state.guideTone.process (channelData, numSamples, static_cast<float> (newFrequency), guideToneLevel);
+
+    lap.mark (BlockProfiler::synthesize);
+}
+
+template <typename SampleType>
+template <int FrameSize>
+void AutotuneEngine<SampleType>::remapBins (ChannelState& state, float correctionRatio, const FormantEnvelope* formants, std::complex<float>* target, int numSamples)
+{
+    const auto& fft_out = state.fft_out;
+    auto& phases = state.phases;
+    const int frameSize = FrameSize > 0 ? FrameSize : static_cast<int> (fft_out.size());
+    const float sampleRateF = static_cast<float> (sampleRate);
+
+    auto nextPhaseLambda = [numSamples, sampleRateF](float frequency, float phase) -> float
+    {
+        // phase increment per sample
+        float phaseIncrement = 2 * M_PI * frequency / sampleRateF;
+        int samplesLeft = numSamples - static_cast<int>(phase * numSamples / (2 * M_PI));
+        phase += phaseIncrement * samplesLeft;
+
+        if (phase >= M_PI)
+            phase -= 2 * M_PI;
+        else if (phase < -1 * M_PI)
+            phase += 2 * M_PI;
+
+        return phase;
+    };
+
+    const auto& sinc = *sincKernel;
+
+    //only the positive frequencies are moved, the negative half stays empty and the
+    //synthesis takes the real part of what is then an analytic signal
+    const int numBins = frameSize / 2;
+
+    for(int bin = 0; bin < numBins; ++bin)
+    {
+        float binFrequency = static_cast<float>(bin) * (sampleRateF / frameSize);
+        float shiftedFrequency = 2*binFrequency * correctionRatio;
+        //shifted_bins[bin] = fft_out[bin];
+        //phases[bin] = nextPhaseLambda(shiftedFrequency, phases[bin]);
+
+        float shiftedBin = correctionRatio * static_cast<float>(bin);
+
+
+        //no interpolation
+        //int intShiftedBin = static_cast<int>(shiftedBin);
+        //intShiftedBin = bin;
+
+        int intShiftedBinLow = static_cast<int>(std::floor(shiftedBin));
+        int intShiftedBinHigh = intShiftedBinLow + 1;
+
+        float distanceLow = shiftedBin - intShiftedBinLow;
+        float distanceHigh = 1.0f - distanceLow;
+
+        float weightLow = sinc(distanceLow);
+        float weightHigh = sinc(distanceHigh);
+
+        if (formants != nullptr)
+        {
+            float formantGain = formants->getCorrection (static_cast<float> (bin), shiftedBin);
+            weightLow *= formantGain;
+            weightHigh *= formantGain;
+        }
+
+        if (intShiftedBinLow >= 0 && intShiftedBinLow < numBins)
+        {
+            target[intShiftedBinLow] = fft_out[bin] * weightLow;
+            phases[intShiftedBinLow] = nextPhaseLambda(shiftedFrequency, phases[bin]);
+        }
+
+        if (intShiftedBinHigh >= 0 && intShiftedBinHigh < numBins)
+        {
+            target[intShiftedBinHigh] = fft_out[bin] * weightHigh;
+        }
+
+        /*
+        if (intShiftedBin < fft_out.size())
+        {
+
+            shifted_bins[intShiftedBin] = std::complex<float> {fft_out[bin].real(),phases[intShiftedBin]};
+            phases[intShiftedBin] = nextPhaseLambda(shiftedFrequency, phases[bin]);
+            //shifted_bins[fftData.size() - intShiftedBin - 1] = std::conj(shifted_bins[intShiftedBin]);
+        }*/
+    }
+}
+
+//==============================================================================
+template class AutotuneEngine<float>;
+template class AutotuneEngine<double>;
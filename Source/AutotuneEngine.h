@@ -0,0 +1,273 @@
+/*
+  ==============================================================================
+
+    AutotuneEngine.h
+
+    The detect / quantize / shift pipeline, templated on the host sample type
+    so float and double buses are processed without a conversion pass.
+    juce::dsp::FFT is single precision, so the spectral stage always runs in
+    float; samples are converted as they are copied into the fft frame.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include "AnalysisDecimator.h"
+#include "BlockProfiler.h"
+#include "ChannelWorkerPool.h"
+#include "FormantEnvelope.h"
+#include "GuideToneBank.h"
+#include "PitchToMidi.h"
+#include "ResonatorBank.h"
+#include "Scale.h"
+#include "SharedTables.h"
+#include <array>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+template <typename SampleType>
+class AutotuneEngine
+{
+public:
+    AutotuneEngine();
+
+    //builds the ffts and buffers for the orders the current range reaches, a lower
+    //range set later asks for its own through getRequestedOrder()
+    void prepare (double newSampleRate, int maximumBlockSize, int numChannels);
+    void reset();
+
+    //everything the next block starts from, so a trace replay can pick up where a
+    //capture started without resetting the engine it captured, see StateArchive.h.
+    //Restoring switches to the saved chunk length, the engine must already have
+    //been prepared with the same settings and orders
+    template <typename Archive>
+    void visitState (Archive& archive)
+    {
+        auto numChannels = static_cast<uint32_t> (channels.size());
+        archive.value (numChannels);
+        archive.value (analysisSamples);
+        archive.value (tunedMinFrequency);
+        archive.value (tunedMaxFrequency);
+        archive.value (tunedSampleRate);
+        archive.vector (bankNotes);
+        archive.check (numChannels == channels.size() && analysisSamples > 0 && analysisSamples <= getPreparedSamples());
+
+        if (! archive.isValid())
+            return;
+
+        if (archive.isRestoring())
+            setOrder (orderForSamples (analysisSamples));
+
+        for (auto& state : channels)
+        {
+            archive.vector (state.inputChunk);
+            archive.vector (state.outputChunk);
+            archive.value (state.chunkPosition);
+            archive.value (state.lastFrameClass);
+            archive.value (state.lastOutput);
+            archive.value (state.lastNote);
+            archive.check (state.inputChunk.size() >= static_cast<size_t> (getPreparedSamples())
+                             && state.outputChunk.size() == state.inputChunk.size()
+                             && state.chunkPosition >= 0 && state.chunkPosition < analysisSamples);
+
+            state.formants.visitState (archive);
+            state.decimator.visitState (archive);
+            state.resonators.visitState (archive);
+            state.guideTone.visitState (archive);
+
+            if (! archive.isValid())
+                return;
+        }
+
+        midiOutput.visitState (archive);
+    }
+
+    //a range that needs a longer chunk than prepared keeps running on the longest
+    //prepared one and leaves its order here, 0 when nothing is waiting. Written by
+    //the audio thread, read from any
+    int getRequestedOrder() const noexcept { return requestedOrder.load(); }
+
+    //builds the ffts and grows the buffers for every order up to newOrder, and makes
+    //no more than those available so a replay can match a capture. Allocates, call
+    //it while the engine isn't processing
+    void prepareOrder (int newOrder);
+    int getPreparedOrder() const noexcept { return preparedOrder; }
+
+    void process (juce::AudioBuffer<SampleType>& buffer, int totalNumInputChannels, int totalNumOutputChannels);
+
+    //channels are spread across this pool when there are more than two of them,
+    //the pool is owned by the processor and may be null
+    void setWorkerPool (ChannelWorkerPool* newPool) { workerPool = newPool; }
+
+    //stage timings of every voiced frame go here when set, may be null
+    void setProfiler (BlockProfiler* newProfiler) { profiler = newProfiler; }
+
+    //keeps the spectral envelope in place when the pitch is corrected
+    bool preserveFormants = true;
+
+    //harmonizer: extra voices stacked on the corrected lead, each one a number
+    //of scale degrees away from the detected note
+    static constexpr int maxHarmonyVoices = 4;
+    int numHarmonyVoices = 0;
+    std::array<int, maxHarmonyVoices> harmonyDegrees { 2, 4, -3, 7 };
+    float harmonyVoiceGain = 0.5f;
+
+    //detection range, bounds the peak search and sets the analysis chunk length,
+    //a high range runs on much shorter frames than a low one. Chunks are gathered
+    //across host blocks, so the output is delayed by getLatencySamples()
+    void setRange (float newMinFrequency, float newMaxFrequency);
+
+    //the current chunk length, valid after prepare and updated by process when the range changes
+    int getLatencySamples() const { return analysisSamples; }
+
+    //spectralPeak picks the loudest fft bin, resonatorBank runs a bank of resonators
+    //tuned to the scale notes in range and reads the note straight off it, on a
+    //copy decimated to 8 - 16 kHz so its cost doesn't grow with the host rate
+    enum class Detector { spectralPeak, resonatorBank };
+    Detector detector = Detector::spectralPeak;
+
+    //guide tone: the corrected pitch resynthesized with guideToneHarmonics 1/k partials
+    //and mixed into the output at guideToneLevel, 0 turns it off
+    float guideToneLevel = 0.0f;
+    int guideToneHarmonics = 3;
+
+    //pitch to midi: the quantized note of every analysis chunk as note on / off at
+    //the chunk's first sample, call writeMidi after process
+    bool midiOutputEnabled = true;
+    PitchToMidi midiOutput;
+    void writeMidi (juce::MidiBuffer& midi);
+
+    //voicing gate: frames below the silence threshold, or crossing zero more often
+    //than unvoicedCrossingRate (crossings per sample), bypass the spectral path
+    bool gateEnabled = true;
+    float silenceThresholdDb = -60.0f;
+    float unvoicedCrossingRate = 0.2f;
+
+private:
+    //unpitched: voiced by the gate but the detector found no pitch in it
+    enum class FrameClass { silent, unvoiced, unpitched, voiced };
+
+    static constexpr int minOrder = 6;
+    static constexpr int maxSupportedOrder = 16;
+
+    //everything a channel writes to, so channels can run on different threads,
+    //including the ffts: JUCE's fallback FFT locks inside perform()
+    struct ChannelState
+    {
+        std::array<std::unique_ptr<juce::dsp::FFT>, maxSupportedOrder + 1> ffts;
+        const juce::dsp::FFT* fft = nullptr;
+
+        std::vector<std::complex<float>> fft_in;
+        std::vector<std::complex<float>> fft_out;
+        std::vector<std::complex<float>> shifted_bins;
+        std::vector<std::complex<float>> voice_bins;
+        std::vector<float> phases;
+        FormantEnvelope formants;
+        AnalysisDecimator decimator;
+        ResonatorBank resonators;
+        GuideToneBank guideTone;
+
+        //the chunk being gathered from the input and the corrected one being played out
+        std::vector<SampleType> inputChunk;
+        std::vector<SampleType> outputChunk;
+        int chunkPosition = 0;
+
+        FrameClass lastFrameClass = FrameClass::voiced;
+        SampleType lastOutput = 0;
+        float lastNote = 0.0f;
+    };
+
+    struct ChannelJob
+    {
+        AutotuneEngine* engine;
+        juce::AudioBuffer<SampleType>* buffer;
+    };
+
+    using ProcessChannelsFunction = void (AutotuneEngine::*) (juce::AudioBuffer<SampleType>&, int);
+
+    //switches to the fft of that order and resizes the scratch buffers, only when the
+    //order changes, the order is clamped to the largest one prepared
+    void setOrder (int newOrder);
+    int analysisSamplesFor (float frequency) const;
+    int getAnalysisSamples() const;
+
+    //retunes the resonator banks when the range or sample rate changed
+    void tuneResonators();
+    static int orderForSamples (int numSamples);
+    void setNumChannels (int numChannels);
+
+    //builds the channel's ffts up to preparedOrder and sizes its chunks for the longest
+    //of them, allocates, so never from the audio thread
+    void prepareFFTs (ChannelState& state);
+    int getPreparedSamples() const { return preparedOrder > 0 ? 1 << (preparedOrder - 1) : 0; }
+
+    //points the channel at the fft of the current order and sizes its scratch buffers
+    void prepareChannel (ChannelState& state);
+
+    //picks the processChannels instantiation for the current frame size, 256 to
+    //2048 point frames are specialized, anything else falls back to the runtime
+    //sized <0> kernel
+    void selectKernel();
+
+    template <int FrameSize>
+    void processChannels (juce::AudioBuffer<SampleType>& buffer, int numChannels);
+
+    FrameClass classifyFrame (const SampleType* data, int numSamples) const;
+
+    //leaves an uncorrected frame dry, easing out of the corrected path when the previous frame took it
+    void passThrough (ChannelState& state, SampleType* channelData, int numSamples, bool wasCorrected);
+    static void smoothTransition (SampleType* data, int numSamples, SampleType previousSample);
+
+    //ChannelWorkerPool task, taskIndex is the channel
+    template <int FrameSize>
+    static void processChannelTask (void* context, int taskIndex);
+
+    template <int FrameSize>
+    void processChannelChunks (int channel, SampleType* channelData, int numSamples);
+
+    template <int FrameSize>
+    void processChannel (int channel, SampleType* channelData, int numSamples);
+
+    //moves every bin of the channel's fft_out by correctionRatio into target
+    template <int FrameSize>
+    void remapBins (ChannelState& state, float correctionRatio, const FormantEnvelope* formants, std::complex<float>* target, int numSamples);
+
+    double sampleRate = 44100.0;
+    double detectionRate = 44100.0;
+    int order = 0;
+    int analysisSamples = 0;
+    int maxAnalysisSamples = 0;
+
+    //every channel gets an fft per order up to preparedOrder, the orders the range
+    //reaches, the interpolation kernel comes from SharedTables
+    int preparedOrder = 0;
+    std::atomic<int> requestedOrder { 0 };
+    std::shared_ptr<const SincKernel> sincKernel;
+
+    static constexpr float lowestFrequency = 20.0f;
+    float minFrequency = 40.0f;
+    float maxFrequency = 1500.0f;
+    static constexpr float periodsPerAnalysis = 2.0f;
+
+    static constexpr int maxResonators = 128;
+    std::vector<float> bankNotes;
+    float tunedMinFrequency = 0.0f;
+    float tunedMaxFrequency = 0.0f;
+    double tunedSampleRate = 0.0;
+
+    ProcessChannelsFunction processChannelsFunction = nullptr;
+
+    std::vector<ChannelState> channels;
+    ChannelWorkerPool* workerPool = nullptr;
+    BlockProfiler* profiler = nullptr;
+
+    static constexpr int transitionSamples = 64;
+    static constexpr int midiSourceChannel = 0;
+
+    Scale<SampleType> _5lim_500hz;
+};
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    BlockProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "BlockProfiler.h"
+#include <cmath>
+
+BlockProfiler::BlockProfiler()
+{
+    microsecondsPerTick = 1.0e6 / static_cast<double> (juce::Time::getHighResolutionTicksPerSecond());
+    reset();
+}
+
+void BlockProfiler::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void BlockProfiler::reset()
+{
+    for (size_t s = 0; s < static_cast<size_t> (numStages); ++s)
+    {
+        stageTicks[s].store (0, std::memory_order_relaxed);
+        stageTotalTicks[s].store (0, std::memory_order_relaxed);
+
+        for (auto& bucket : stageHistograms[s])
+            bucket.store (0, std::memory_order_relaxed);
+    }
+
+    for (auto& bucket : loadHistogram)
+        bucket.store (0, std::memory_order_relaxed);
+
+    totalLoad.store (0.0, std::memory_order_relaxed);
+    maxLoad.store (0.0f, std::memory_order_relaxed);
+    numBlocks.store (0, std::memory_order_relaxed);
+    deadlineMisses.store (0, std::memory_order_relaxed);
+}
+
+void BlockProfiler::endBlock (int numSamples, juce::int64 blockTicks) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    for (size_t s = 0; s < static_cast<size_t> (numStages); ++s)
+    {
+        const auto ticks = stageTicks[s].exchange (0, std::memory_order_relaxed);
+        stageTotalTicks[s].fetch_add (ticks, std::memory_order_relaxed);
+
+        //bucket index is the bit length of the whole microseconds
+        auto microseconds = static_cast<std::uint64_t> (ticksToMicroseconds (ticks));
+        int bucket = 0;
+        while (microseconds > 0 && bucket < numTimeBuckets - 1)
+        {
+            microseconds >>= 1;
+            ++bucket;
+        }
+
+        stageHistograms[s][static_cast<size_t> (bucket)].fetch_add (1, std::memory_order_relaxed);
+    }
+
+    //only the audio thread writes the block counters, so plain load / store is enough
+    const double budgetMicroseconds = 1.0e6 * numSamples / sampleRate;
+    const auto load = static_cast<float> (ticksToMicroseconds (blockTicks) / budgetMicroseconds);
+
+    const int loadBucket = juce::jlimit (0, numLoadBuckets - 1, static_cast<int> (load / loadBucketWidth));
+    loadHistogram[static_cast<size_t> (loadBucket)].fetch_add (1, std::memory_order_relaxed);
+
+    totalLoad.store (totalLoad.load (std::memory_order_relaxed) + load, std::memory_order_relaxed);
+    if (load > maxLoad.load (std::memory_order_relaxed))
+        maxLoad.store (load, std::memory_order_relaxed);
+
+    if (load > getDeadlineFraction())
+        deadlineMisses.fetch_add (1, std::memory_order_relaxed);
+
+    numBlocks.fetch_add (1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+double BlockProfiler::bucketPercentile (const std::atomic<std::uint32_t>* buckets, int numBuckets, float percentile)
+{
+    std::uint64_t total = 0;
+    for (int b = 0; b < numBuckets; ++b)
+        total += buckets[b].load (std::memory_order_relaxed);
+
+    if (total == 0)
+        return 0.0;
+
+    //index of the first bucket that reaches the percentile
+    const auto threshold = static_cast<std::uint64_t> (std::ceil (percentile * static_cast<float> (total)));
+    std::uint64_t count = 0;
+
+    for (int b = 0; b < numBuckets; ++b)
+    {
+        count += buckets[b].load (std::memory_order_relaxed);
+        if (count >= threshold)
+            return static_cast<double> (b);
+    }
+
+    return static_cast<double> (numBuckets - 1);
+}
+
+BlockProfiler::Summary BlockProfiler::getStageSummary (Stage stage) const
+{
+    const auto& histogram = stageHistograms[static_cast<size_t> (stage)];
+
+    Summary summary;
+    summary.blocks = getNumBlocks();
+
+    if (summary.blocks > 0)
+        summary.meanMicroseconds = ticksToMicroseconds (stageTotalTicks[static_cast<size_t> (stage)].load (std::memory_order_relaxed))
+                                     / static_cast<double> (summary.blocks);
+
+    //upper edge of the bucket
+    summary.p50Microseconds = std::exp2 (bucketPercentile (histogram.data(), numTimeBuckets, 0.5f));
+    summary.p99Microseconds = std::exp2 (bucketPercentile (histogram.data(), numTimeBuckets, 0.99f));
+    return summary;
+}
+
+float BlockProfiler::getMeanLoad() const
+{
+    const auto blocks = getNumBlocks();
+    return blocks > 0 ? static_cast<float> (totalLoad.load (std::memory_order_relaxed) / static_cast<double> (blocks)) : 0.0f;
+}
+
+float BlockProfiler::getLoadPercentile (float percentile) const
+{
+    const auto bucket = bucketPercentile (loadHistogram.data(), numLoadBuckets, percentile);
+    return static_cast<float> (bucket + 1.0) * loadBucketWidth;
+}
+
+const char* BlockProfiler::getStageName (Stage stage)
+{
+    switch (stage)
+    {
+        case detect:     return "detect";
+        case quantize:   return "quantize";
+        case shift:      return "shift";
+        case synthesize: return "synthesize";
+        case numStages:  break;
+    }
+
+    return "";
+}
+
+//==============================================================================
+juce::var BlockProfiler::toVar() const
+{
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("blocks", static_cast<juce::int64> (getNumBlocks()));
+    root->setProperty ("deadlineFraction", getDeadlineFraction());
+    root->setProperty ("deadlineMisses", static_cast<juce::int64> (getDeadlineMisses()));
+    root->setProperty ("meanLoad", getMeanLoad());
+    root->setProperty ("p99Load", getLoadPercentile (0.99f));
+    root->setProperty ("maxLoad", getMaxLoad());
+
+    juce::Array<juce::var> loadBuckets;
+    for (const auto& bucket : loadHistogram)
+        loadBuckets.add (static_cast<int> (bucket.load (std::memory_order_relaxed)));
+    root->setProperty ("loadHistogram", loadBuckets);
+
+    auto* stages = new juce::DynamicObject();
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        const auto stage = static_cast<Stage> (s);
+        const auto summary = getStageSummary (stage);
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("meanMicroseconds", summary.meanMicroseconds);
+        entry->setProperty ("p50Microseconds", summary.p50Microseconds);
+        entry->setProperty ("p99Microseconds", summary.p99Microseconds);
+
+        juce::Array<juce::var> buckets;
+        for (const auto& bucket : stageHistograms[static_cast<size_t> (s)])
+            buckets.add (static_cast<int> (bucket.load (std::memory_order_relaxed)));
+        entry->setProperty ("histogram", buckets);
+
+        stages->setProperty (getStageName (stage), juce::var (entry));
+    }
+
+    root->setProperty ("stages", juce::var (stages));
+    return juce::var (root);
+}
+
+juce::String BlockProfiler::toJson() const
+{
+    return juce::JSON::toString (toVar());
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    BlockProfiler.h
+
+    Per-block CPU accounting for the audio callback. The engine times each
+    pipeline stage with high resolution ticks, the processor times the whole
+    block, and both land in lock-free histograms that the editor polls and
+    the console target exports as JSON. Blocks that take longer than a set
+    fraction of their own duration are counted as deadline misses.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+class BlockProfiler
+{
+public:
+    enum Stage { detect, quantize, shift, synthesize, numStages };
+
+    //stage buckets are powers of two microseconds, bucket b holds [2^(b-1), 2^b)
+    static constexpr int numTimeBuckets = 20;
+
+    //block load buckets are loadBucketWidth of the buffer duration wide, the last
+    //one holds everything slower
+    static constexpr int numLoadBuckets = 40;
+    static constexpr float loadBucketWidth = 0.05f;
+
+    BlockProfiler();
+
+    void prepare (double newSampleRate);
+
+    //clears every histogram, not safe against a concurrent block
+    void reset();
+
+    //a block costing more than this fraction of its duration counts as a miss
+    void setDeadlineFraction (float newFraction)  { deadlineFraction.store (newFraction, std::memory_order_relaxed); }
+    float getDeadlineFraction() const             { return deadlineFraction.load (std::memory_order_relaxed); }
+
+    //times consecutive stages on one thread: every mark charges the ticks since the
+    //previous mark to a stage, does nothing when there's no profiler
+    class Lap
+    {
+    public:
+        explicit Lap (BlockProfiler* owner) noexcept
+            : profiler (owner), last (owner != nullptr ? juce::Time::getHighResolutionTicks() : 0) {}
+
+        void mark (Stage stage) noexcept
+        {
+            if (profiler == nullptr)
+                return;
+
+            const auto now = juce::Time::getHighResolutionTicks();
+            profiler->stageTicks[static_cast<size_t> (stage)].fetch_add (now - last, std::memory_order_relaxed);
+            last = now;
+        }
+
+    private:
+        BlockProfiler* profiler;
+        juce::int64 last;
+    };
+
+    //audio thread, once every channel is done: folds the stage times of the block
+    //into their histograms and records the block's load
+    void endBlock (int numSamples, juce::int64 blockTicks) noexcept;
+
+    struct Summary
+    {
+        juce::uint64 blocks = 0;
+        double meanMicroseconds = 0.0;
+        double p50Microseconds = 0.0;
+        double p99Microseconds = 0.0;
+    };
+
+    Summary getStageSummary (Stage stage) const;
+    juce::uint64 getNumBlocks() const   { return numBlocks.load (std::memory_order_relaxed); }
+    juce::uint64 getDeadlineMisses() const { return deadlineMisses.load (std::memory_order_relaxed); }
+    float getMeanLoad() const;
+    float getMaxLoad() const            { return maxLoad.load (std::memory_order_relaxed); }
+
+    //load that percentile of blocks stay under, at bucket resolution
+    float getLoadPercentile (float percentile) const;
+
+    static const char* getStageName (Stage stage);
+
+    //every counter and histogram, written by the console target's --regress --json
+    //and --replay --profile
+    juce::var toVar() const;
+    juce::String toJson() const;
+
+private:
+    using Histogram = std::array<std::atomic<std::uint32_t>, numTimeBuckets>;
+
+    static double bucketPercentile (const std::atomic<std::uint32_t>* buckets, int numBuckets, float percentile);
+    double ticksToMicroseconds (juce::int64 ticks) const noexcept { return static_cast<double> (ticks) * microsecondsPerTick; }
+
+    double sampleRate = 44100.0;
+    double microsecondsPerTick = 0.0;
+    std::atomic<float> deadlineFraction { 0.7f };
+
+    //written by whichever thread ran the stage, drained by endBlock
+    std::array<std::atomic<juce::int64>, numStages> stageTicks;
+
+    std::array<Histogram, numStages> stageHistograms;
+    std::array<std::atomic<juce::int64>, numStages> stageTotalTicks;
+
+    std::array<std::atomic<std::uint32_t>, numLoadBuckets> loadHistogram;
+    std::atomic<double> totalLoad { 0.0 };
+    std::atomic<float> maxLoad { 0.0f };
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<juce::uint64> deadlineMisses { 0 };
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "ChannelWorkerPool.h"
+#include <thread>
+
+class ChannelWorkerPool::Worker : public juce::Thread
+{
+public:
+    explicit Worker (ChannelWorkerPool& p) : juce::Thread ("autotune channel worker"), pool (p) {}
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        wake();
+        stopThread (1000);
+    }
+
+    //called from the audio thread, only signals (and so locks) if the worker actually parked
+    void wake()
+    {
+        if (sleeping.load())
+            wakeEvent.signal();
+    }
+
+    void run() override
+    {
+        //the tasks have to flush denormals like the audio thread does, or a channel
+        //would stall on them and come out different depending on who ran it
+        juce::ScopedNoDenormals noDenormals;
+
+        uint32_t lastGeneration = generationOf (pool.work.load());
+
+        while (! threadShouldExit())
+        {
+            uint32_t generation = lastGeneration;
+
+            for (int i = 0; i < spinIterations && generation == lastGeneration; ++i)
+            {
+                std::this_thread::yield();
+                generation = generationOf (pool.work.load());
+            }
+
+            if (generation == lastGeneration)
+            {
+                sleeping.store (true);
+
+                //re-check after announcing, run() may have published in between
+                if (generationOf (pool.work.load()) == lastGeneration && ! threadShouldExit())
+                    wakeEvent.wait (100);
+
+                sleeping.store (false);
+                continue;
+            }
+
+            pool.runTasks (generation);
+            lastGeneration = generation;
+        }
+    }
+
+private:
+    ChannelWorkerPool& pool;
+    juce::WaitableEvent wakeEvent;
+    std::atomic<bool> sleeping { false };
+};
+
+//==============================================================================
+ChannelWorkerPool::ChannelWorkerPool (int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back (std::make_unique<Worker> (*this));
+        workers.back()->startThread (juce::Thread::Priority::highest);
+    }
+}
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    workers.clear();
+}
+
+std::shared_ptr<ChannelWorkerPool> ChannelWorkerPool::getShared()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<ChannelWorkerPool> shared;
+
+    const std::lock_guard<std::mutex> lock (mutex);
+
+    if (auto pool = shared.lock())
+        return pool;
+
+    //the calling thread always takes a share, so one worker per remaining core
+    auto pool = std::make_shared<ChannelWorkerPool> (juce::jlimit (0, maxWorkers, juce::SystemStats::getNumCpus() - 1));
+    shared = pool;
+    return pool;
+}
+
+uint64_t ChannelWorkerPool::pack (uint32_t generation, int numTasks, int nextTask)
+{
+    return (static_cast<uint64_t> (generation) << 32)
+         | (static_cast<uint64_t> (numTasks & 0xffff) << 16)
+         | static_cast<uint64_t> (nextTask & 0xffff);
+}
+
+void ChannelWorkerPool::run (int numTasks, TaskFunction task, void* context)
+{
+    jassert (numTasks < 0xffff);
+
+    if (numTasks <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    //another instance's job has the workers, this one doesn't wait for it
+    if (workers.empty() || numTasks == 1 || busy.exchange (true))
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task (context, i);
+
+        return;
+    }
+
+    //the previous job has fully completed, so nobody can be reading these
+    currentTask = task;
+    currentContext = context;
+    completedTasks.store (0);
+
+    const uint32_t generation = generationOf (work.load()) + 1;
+    work.store (pack (generation, numTasks, 0));
+
+    for (auto& worker : workers)
+        worker->wake();
+
+    runTasks (generation);
+
+    while (completedTasks.load() < numTasks)
+        std::this_thread::yield();
+
+    busy.store (false);
+}
+
+void ChannelWorkerPool::runTasks (uint32_t generation)
+{
+    uint64_t current = work.load();
+
+    for (;;)
+    {
+        if (generationOf (current) != generation || nextTaskOf (current) >= numTasksOf (current))
+            return;
+
+        const int taskIndex = nextTaskOf (current);
+
+        if (! work.compare_exchange_weak (current, pack (generation, numTasksOf (current), taskIndex + 1)))
+            continue;
+
+        //a successful claim means this job can't complete yet, so task and context are stable
+        currentTask (currentContext, taskIndex);
+        completedTasks.fetch_add (1);
+        current = work.load();
+    }
+}
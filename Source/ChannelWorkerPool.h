@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.h
+
+    Small pool of pre-spawned threads that share per-channel work with the
+    audio thread inside one processBlock call. run() never allocates and
+    work is claimed through a single atomic. Idle workers spin for a while
+    before parking on their own event, and the audio thread only signals the
+    workers that actually parked: that signal takes the event's mutex, so
+    run() only locks after a pause longer than the spin, never while blocks
+    keep arriving.
+    One pool is shared by every instance in the process, so a session full of
+    surround tracks runs at most one worker per spare core instead of a set
+    per instance. An instance whose audio thread finds the workers busy with
+    another instance's job runs its own tasks inline rather than waiting.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ChannelWorkerPool
+{
+public:
+    using TaskFunction = void (*) (void* context, int taskIndex);
+
+    //spawns the workers, call from prepareToPlay, never from the audio thread
+    explicit ChannelWorkerPool (int numWorkers);
+    ~ChannelWorkerPool();
+
+    //the process wide pool, built by the first instance that asks and stopped when
+    //the last one lets go. Locks, so never call it from the audio thread
+    static std::shared_ptr<ChannelWorkerPool> getShared();
+
+    int getNumWorkers() const { return static_cast<int> (workers.size()); }
+
+    //runs task (context, 0 .. numTasks - 1) across the workers and the calling
+    //thread, returns once every task has finished. Safe to call from several
+    //threads at once, only one of them gets the workers
+    void run (int numTasks, TaskFunction task, void* context);
+
+    static constexpr int maxWorkers = 8;
+
+private:
+    class Worker;
+
+    //claims and runs tasks of the given generation until none are left
+    void runTasks (uint32_t generation);
+
+    //work is packed as generation (32 bits) | task count (16 bits) | next task (16 bits)
+    //so a claim can never mix up two jobs
+    static uint64_t pack (uint32_t generation, int numTasks, int nextTask);
+    static uint32_t generationOf (uint64_t work) { return static_cast<uint32_t> (work >> 32); }
+    static int numTasksOf (uint64_t work)        { return static_cast<int> ((work >> 16) & 0xffff); }
+    static int nextTaskOf (uint64_t work)        { return static_cast<int> (work & 0xffff); }
+
+    std::atomic<bool> busy { false };
+    std::atomic<uint64_t> work { 0 };
+    std::atomic<int> completedTasks { 0 };
+    TaskFunction currentTask = nullptr;
+    void* currentContext = nullptr;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    static constexpr int spinIterations = 4000;
+
+    JUCE_DECLARE_NON_COPYABLE (ChannelWorkerPool)
+};
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    FormantEnvelope.cpp
+
+  ==============================================================================
+*/
+
+#include "FormantEnvelope.h"
+#include <cmath>
+
+void FormantEnvelope::prepare (int newFftSize)
+{
+    if (newFftSize == fftSize)
+        return;
+
+    fftSize = newFftSize;
+    logSpectrum.assign (static_cast<size_t> (fftSize), { 0.0f, 0.0f });
+    cepstrum.assign (static_cast<size_t> (fftSize), { 0.0f, 0.0f });
+    envelope.assign (static_cast<size_t> (fftSize), 1.0f);
+    reset();
+}
+
+void FormantEnvelope::reset()
+{
+    std::fill (envelope.begin(), envelope.end(), 1.0f);
+    cachedFrequency = -1.0f;
+    hopsSinceUpdate = 0;
+}
+
+bool FormantEnvelope::isStale (float pitchFrequency) const
+{
+    if (cachedFrequency <= 0.0f || pitchFrequency <= 0.0f)
+        return true;
+
+    if (hopsSinceUpdate >= maxCachedHops)
+        return true;
+
+    return std::abs (1200.0f * std::log2 (pitchFrequency / cachedFrequency)) > stableCents;
+}
+
+void FormantEnvelope::update (const juce::dsp::FFT& fft, const std::complex<float>* spectrum,
+                              float pitchFrequency, float sampleRate)
+{
+    if (! isStale (pitchFrequency))
+    {
+        ++hopsSinceUpdate;
+        return;
+    }
+
+    //real cepstrum: inverse transform of the log magnitude
+    for (int i = 0; i < fftSize; ++i)
+        logSpectrum[i] = { std::log (std::abs (spectrum[i]) + 1.0e-9f), 0.0f };
+
+    fft.perform (logSpectrum.data(), cepstrum.data(), true);
+
+    //lifter away everything from half the pitch period upwards, that is the harmonic fine structure
+    float period = sampleRate / (pitchFrequency > 0.0f ? pitchFrequency : 1000.0f);
+    int cutoff = juce::jlimit (4, fftSize / 2 - 1, static_cast<int> (0.5f * period));
+
+    for (int i = cutoff; i <= fftSize - cutoff; ++i)
+        cepstrum[i] = { 0.0f, 0.0f };
+
+    fft.perform (cepstrum.data(), logSpectrum.data(), false);
+
+    for (int i = 0; i < fftSize; ++i)
+        envelope[i] = std::exp (logSpectrum[i].real());
+
+    cachedFrequency = pitchFrequency;
+    hopsSinceUpdate = 0;
+}
+
+float FormantEnvelope::getMagnitude (float bin) const
+{
+    if (bin <= 0.0f)
+        return envelope[0];
+
+    if (bin >= static_cast<float> (fftSize - 1))
+        return envelope[fftSize - 1];
+
+    int low = static_cast<int> (bin);
+    float fraction = bin - static_cast<float> (low);
+    return envelope[low] + fraction * (envelope[low + 1] - envelope[low]);
+}
+
+float FormantEnvelope::getCorrection (float fromBin, float toBin) const
+{
+    if (fftSize == 0)
+        return 1.0f;
+
+    float correction = getMagnitude (toBin) / juce::jmax (getMagnitude (fromBin), 1.0e-9f);
+    return juce::jmin (correction, maxCorrection);
+}
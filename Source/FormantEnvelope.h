@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    FormantEnvelope.h
+
+    Cepstral spectral envelope taken from the analysis frame, used to keep
+    formants in place while the pitch is shifted.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include <complex>
+#include <vector>
+
+class FormantEnvelope
+{
+public:
+    //resizes the scratch buffers, only allocates when the fft size changes
+    void prepare (int newFftSize);
+    void reset();
+
+    //the cached envelope and how long it has been reused, see StateArchive.h
+    template <typename Archive>
+    void visitState (Archive& archive)
+    {
+        archive.vector (envelope);
+        archive.value (cachedFrequency);
+        archive.value (hopsSinceUpdate);
+        archive.check (envelope.size() == static_cast<size_t> (fftSize));
+    }
+
+    //re-estimates the envelope from the forward fft frame, unless the pitch
+    //has stayed within stableCents of the last estimate, in which case the
+    //cached envelope is reused for up to maxCachedHops frames
+    void update (const juce::dsp::FFT& fft, const std::complex<float>* spectrum,
+                 float pitchFrequency, float sampleRate);
+
+    //gain that moves a partial from one bin to another without moving the envelope
+    float getCorrection (float fromBin, float toBin) const;
+
+private:
+    float getMagnitude (float bin) const;
+    bool isStale (float pitchFrequency) const;
+
+    int fftSize = 0;
+    std::vector<std::complex<float>> logSpectrum;
+    std::vector<std::complex<float>> cepstrum;
+    std::vector<float> envelope;
+
+    float cachedFrequency = -1.0f;
+    int hopsSinceUpdate = 0;
+
+    static constexpr float stableCents = 30.0f;
+    static constexpr int maxCachedHops = 8;
+    static constexpr float maxCorrection = 10.0f;
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    GuideToneBank.cpp
+
+  ==============================================================================
+*/
+
+#include "GuideToneBank.h"
+#include <cmath>
+
+void GuideToneBank::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void GuideToneBank::reset()
+{
+    //every oscillator starts at phase 0, so a fade in starts from silence
+    re.fill (Vec::expand (1.0f));
+    im.fill (Vec::expand (0.0f));
+    rotationRe.fill (Vec::expand (1.0f));
+    rotationIm.fill (Vec::expand (0.0f));
+    chirpRe.fill (Vec::expand (1.0f));
+    chirpIm.fill (Vec::expand (0.0f));
+    amplitude.fill (Vec::expand (0.0f));
+    amplitudeStep.fill (Vec::expand (0.0f));
+
+    targetAngle.fill (0.0f);
+    targetAmplitude.fill (0.0f);
+    frequency = 0.0f;
+    silent = true;
+}
+
+void GuideToneBank::setTargets (float newFrequency, float newGain, int numSamples)
+{
+    //without a pitch the partials hold their frequency and fade out
+    if (newFrequency > 0.0f)
+        frequency = newFrequency;
+    else
+        newGain = 0.0f;
+
+    const float maxFrequency = maxPartialRatio * static_cast<float> (sampleRate);
+
+    for (int p = 0; p < maxPartials; ++p)
+    {
+        const size_t g = static_cast<size_t> (p) / lanes;
+        const size_t lane = static_cast<size_t> (p) % lanes;
+        const float harmonic = static_cast<float> (p + 1);
+
+        const bool active = p < numPartials && harmonic * frequency < maxFrequency;
+        const float angle = static_cast<float> (juce::MathConstants<double>::twoPi * harmonic * frequency / sampleRate);
+        const float currentAmplitude = amplitude[g].get (lane);
+
+        targetAngle[static_cast<size_t> (p)] = angle;
+        targetAmplitude[static_cast<size_t> (p)] = active ? newGain / harmonic : 0.0f;
+
+        amplitudeStep[g].set (lane, (targetAmplitude[static_cast<size_t> (p)] - currentAmplitude) / static_cast<float> (numSamples));
+
+        if (currentAmplitude <= 0.0f)
+        {
+            //a silent partial starts straight at its new frequency, there's nothing to glide
+            rotationRe[g].set (lane, std::cos (angle));
+            rotationIm[g].set (lane, std::sin (angle));
+            chirpRe[g].set (lane, 1.0f);
+            chirpIm[g].set (lane, 0.0f);
+        }
+        else
+        {
+            //glide: turn the per sample rotation by an equal step every sample
+            const float currentAngle = std::atan2 (rotationIm[g].get (lane), rotationRe[g].get (lane));
+            const float step = (angle - currentAngle) / static_cast<float> (numSamples);
+            chirpRe[g].set (lane, std::cos (step));
+            chirpIm[g].set (lane, std::sin (step));
+        }
+    }
+}
+
+void GuideToneBank::finishBlock()
+{
+    silent = true;
+
+    for (int p = 0; p < maxPartials; ++p)
+    {
+        const size_t g = static_cast<size_t> (p) / lanes;
+        const size_t lane = static_cast<size_t> (p) % lanes;
+        const float angle = targetAngle[static_cast<size_t> (p)];
+
+        rotationRe[g].set (lane, std::cos (angle));
+        rotationIm[g].set (lane, std::sin (angle));
+        amplitude[g].set (lane, targetAmplitude[static_cast<size_t> (p)]);
+
+        const float x = re[g].get (lane);
+        const float y = im[g].get (lane);
+        const float magnitude = std::sqrt (x * x + y * y);
+
+        if (magnitude > 0.0f)
+        {
+            re[g].set (lane, x / magnitude);
+            im[g].set (lane, y / magnitude);
+        }
+        else
+        {
+            re[g].set (lane, 1.0f);
+            im[g].set (lane, 0.0f);
+        }
+
+        if (targetAmplitude[static_cast<size_t> (p)] > 0.0f)
+            silent = false;
+    }
+}
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    GuideToneBank.h
+
+    Resynthesizes the corrected pitch as a monitoring guide tone: the
+    fundamental plus a few 1/k harmonics, each one a recursive quadrature
+    oscillator (a unit complex number rotated once per sample), SIMD across
+    partials. No sin or fmod per sample, frequency changes glide across the
+    block by rotating the rotation itself, and amplitude is ramped, so note
+    changes and onsets don't click.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+
+class GuideToneBank
+{
+public:
+    static constexpr int maxPartials = 8;
+
+    void prepare (double newSampleRate);
+    void reset();
+
+    //the oscillators, where their rotations and amplitudes ended the last block,
+    //see StateArchive.h. Chirps, steps and targets are set afresh every block
+    template <typename Archive>
+    void visitState (Archive& archive)
+    {
+        archive.value (re);
+        archive.value (im);
+        archive.value (rotationRe);
+        archive.value (rotationIm);
+        archive.value (amplitude);
+        archive.value (numPartials);
+        archive.value (frequency);
+        archive.value (silent);
+    }
+
+    void setNumPartials (int newNumPartials) { numPartials = juce::jlimit (1, maxPartials, newNumPartials); }
+
+    //adds the tone to data while gliding from the previous frequency and gain to
+    //these over the block, a frequency or gain of 0 fades the tone out
+    template <typename SampleType>
+    void process (SampleType* data, int numSamples, float newFrequency, float newGain)
+    {
+        if (numSamples <= 0 || (silent && (newGain <= 0.0f || newFrequency <= 0.0f)))
+            return;
+
+        setTargets (newFrequency, newGain, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sample = 0.0f;
+
+            for (size_t g = 0; g < numGroups; ++g)
+            {
+                sample += (amplitude[g] * im[g]).sum();
+
+                const auto newRe = re[g] * rotationRe[g] - im[g] * rotationIm[g];
+                im[g] = re[g] * rotationIm[g] + im[g] * rotationRe[g];
+                re[g] = newRe;
+
+                const auto newRotationRe = rotationRe[g] * chirpRe[g] - rotationIm[g] * chirpIm[g];
+                rotationIm[g] = rotationRe[g] * chirpIm[g] + rotationIm[g] * chirpRe[g];
+                rotationRe[g] = newRotationRe;
+
+                amplitude[g] += amplitudeStep[g];
+            }
+
+            data[i] += static_cast<SampleType> (sample);
+        }
+
+        finishBlock();
+    }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t lanes = Vec::SIMDNumElements;
+    static constexpr size_t numGroups = (maxPartials + lanes - 1) / lanes;
+
+    //per lane chirp and amplitude step that land on the targets after numSamples
+    void setTargets (float newFrequency, float newGain, int numSamples);
+
+    //snaps rotations and amplitudes to their targets and pulls the oscillators
+    //back onto the unit circle, so float rounding can't build up across blocks
+    void finishBlock();
+
+    std::array<Vec, numGroups> re, im;
+    std::array<Vec, numGroups> rotationRe, rotationIm;
+    std::array<Vec, numGroups> chirpRe, chirpIm;
+    std::array<Vec, numGroups> amplitude, amplitudeStep;
+
+    std::array<float, maxPartials> targetAngle {};
+    std::array<float, maxPartials> targetAmplitude {};
+
+    double sampleRate = 44100.0;
+    int numPartials = 1;
+    float frequency = 0.0f;
+    bool silent = true;
+
+    //partials above this fraction of the sample rate are left out, so the tone stays band limited
+    static constexpr float maxPartialRatio = 0.45f;
+};
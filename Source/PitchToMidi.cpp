@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    PitchToMidi.cpp
+
+  ==============================================================================
+*/
+
+#include "PitchToMidi.h"
+#include <cmath>
+
+void PitchToMidi::reset()
+{
+    numEvents = 0;
+    releasePending = currentNote >= 0;
+}
+
+void PitchToMidi::addFrame (int sampleOffset, float noteFrequency, float rmsLevel) noexcept
+{
+    if (releasePending)
+    {
+        release (0);
+        releasePending = false;
+    }
+
+    const float levelDb = juce::Decibels::gainToDecibels (rmsLevel, -120.0f);
+    const int note = noteFrequency > 0.0f ? noteNumberFor (noteFrequency) : -1;
+
+    const bool sounding = currentNote >= 0;
+
+    if (sounding)
+    {
+        //hysteresis: a sounding note holds until the level drops well below the onset
+        if (note < 0 || levelDb < onsetThresholdDb - hysteresisDb)
+        {
+            release (sampleOffset);
+            return;
+        }
+
+        if (note == currentNote)
+            return;
+
+        //legato move to the next scale note
+        release (sampleOffset);
+    }
+
+    if (note >= 0 && (sounding || levelDb >= onsetThresholdDb))
+    {
+        addEvent (sampleOffset, note, velocityFor (levelDb));
+        currentNote = note;
+    }
+}
+
+void PitchToMidi::release (int sampleOffset) noexcept
+{
+    if (currentNote < 0)
+        return;
+
+    addEvent (sampleOffset, currentNote, 0);
+    currentNote = -1;
+}
+
+void PitchToMidi::writeTo (juce::MidiBuffer& midi)
+{
+    if (releasePending)
+    {
+        release (0);
+        releasePending = false;
+    }
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        const auto& event = events[static_cast<size_t> (i)];
+
+        if (event.velocity > 0)
+            midi.addEvent (juce::MidiMessage::noteOn (midiChannel, event.noteNumber, event.velocity), event.sampleOffset);
+        else
+            midi.addEvent (juce::MidiMessage::noteOff (midiChannel, event.noteNumber), event.sampleOffset);
+    }
+
+    numEvents = 0;
+}
+
+void PitchToMidi::addEvent (int sampleOffset, int noteNumber, std::uint8_t velocity) noexcept
+{
+    //a full block drops the extra onsets but never a note off
+    if (numEvents >= maxEvents - 1 && velocity > 0)
+        return;
+
+    if (numEvents >= maxEvents)
+        return;
+
+    events[static_cast<size_t> (numEvents++)] = { sampleOffset, noteNumber, velocity };
+}
+
+//==============================================================================
+int PitchToMidi::noteNumberFor (float frequency) noexcept
+{
+    //nearest equal tempered key, the just intonation detune is left to the receiver
+    return juce::jlimit (0, 127, static_cast<int> (std::lround (69.0f + 12.0f * std::log2 (frequency / 440.0f))));
+}
+
+std::uint8_t PitchToMidi::velocityFor (float levelDb) const noexcept
+{
+    const float position = (levelDb - onsetThresholdDb) / juce::jmax (velocityRangeDb, 1.0f);
+    return static_cast<std::uint8_t> (juce::jlimit (1, 127, 1 + juce::roundToInt (126.0f * position)));
+}
+
+float PitchToMidi::getRms (const float* data, int numSamples) noexcept
+{
+    float sumOfSquares = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        sumOfSquares += data[i] * data[i];
+
+    return numSamples > 0 ? std::sqrt (sumOfSquares / static_cast<float> (numSamples)) : 0.0f;
+}
+
+float PitchToMidi::getRms (const double* data, int numSamples) noexcept
+{
+    double sumOfSquares = 0.0;
+    for (int i = 0; i < numSamples; ++i)
+        sumOfSquares += data[i] * data[i];
+
+    return numSamples > 0 ? static_cast<float> (std::sqrt (sumOfSquares / numSamples)) : 0.0f;
+}
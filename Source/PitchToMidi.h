@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    PitchToMidi.h
+
+    Turns the engine's per-chunk analysis (the quantized note and the input
+    level) into note on / off messages at the sample where each corrected
+    chunk starts playing, so the one detection pass drives both the
+    correction and midi capture.
+    A note starts when the level rises above the onset threshold and ends
+    once it falls hysteresisDb below it, so a note hovering around the
+    threshold doesn't retrigger. Velocity follows the level at the onset.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+
+class PitchToMidi
+{
+public:
+    float onsetThresholdDb = -40.0f;
+    float hysteresisDb = 6.0f;
+
+    //level above the onset threshold that maps to full velocity, the threshold itself is velocity 1
+    float velocityRangeDb = 40.0f;
+
+    int midiChannel = 1;
+
+    //a note that is still sounding is ended at the start of the next block
+    void reset();
+
+    //the sounding note and anything still waiting for writeTo, see StateArchive.h
+    template <typename Archive>
+    void visitState (Archive& archive)
+    {
+        archive.value (events);
+        archive.value (numEvents);
+        archive.value (currentNote);
+        archive.value (releasePending);
+        archive.check (numEvents >= 0 && numEvents <= maxEvents);
+    }
+
+    //one analysis chunk, in order: where it starts playing in the block, the quantized note
+    //(0 when unpitched) and the rms of the chunk's input
+    void addFrame (int sampleOffset, float noteFrequency, float rmsLevel) noexcept;
+
+    //ends any sounding note at sampleOffset, used when midi output is switched off
+    void release (int sampleOffset) noexcept;
+
+    //adds the block's events to midi and starts collecting the next block
+    void writeTo (juce::MidiBuffer& midi);
+
+    static float getRms (const float* data, int numSamples) noexcept;
+    static float getRms (const double* data, int numSamples) noexcept;
+
+private:
+    struct Event
+    {
+        int sampleOffset;
+        int noteNumber;
+        std::uint8_t velocity;  //0 for a note off
+    };
+
+    void addEvent (int sampleOffset, int noteNumber, std::uint8_t velocity) noexcept;
+
+    static int noteNumberFor (float frequency) noexcept;
+    std::uint8_t velocityFor (float levelDb) const noexcept;
+
+    //a block holds one event pair per analysis chunk at most, chunks are at least 64 samples
+    static constexpr int maxEvents = 256;
+    std::array<Event, maxEvents> events;
+    int numEvents = 0;
+
+    int currentNote = -1;
+    bool releasePending = false;
+};
@@ -16,6 +16,25 @@ SuperautotuneAudioProcessorEditor::SuperautotuneAudioProcessorEditor (Superautot
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     setSize (400, 300);
+
+    captureButton.setToggleState (audioProcessor.isCapturingTrace(), juce::dontSendNotification);
+    captureButton.onClick = [this]
+    {
+        if (! captureButton.getToggleState())
+        {
+            audioProcessor.stopTraceCapture();
+            return;
+        }
+
+        const auto folder = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory).getChildFile ("super-autotune traces");
+        folder.createDirectory();
+
+        if (! audioProcessor.startTraceCapture (folder.getNonexistentChildFile ("trace", ".satrace")))
+            captureButton.setToggleState (false, juce::dontSendNotification);
+    };
+    addAndMakeVisible (captureButton);
+
+    startTimerHz (4);
 }
 
 SuperautotuneAudioProcessorEditor::~SuperautotuneAudioProcessorEditor()
@@ -28,13 +47,42 @@ void SuperautotuneAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
+    //cpu readout: block load against the callback deadline, then the cost of each stage
+    const auto& profiler = audioProcessor.getProfiler();
+
+    juce::StringArray lines;
+    lines.add ("block load   mean " + juce::String (100.0f * profiler.getMeanLoad(), 1) + "%"
+               + "   p99 " + juce::String (100.0f * profiler.getLoadPercentile (0.99f), 0) + "%"
+               + "   max " + juce::String (100.0f * profiler.getMaxLoad(), 1) + "%");
+    lines.add ("deadline misses (> " + juce::String (100.0f * profiler.getDeadlineFraction(), 0) + "%)   "
+               + juce::String (static_cast<juce::int64> (profiler.getDeadlineMisses())) + " of "
+               + juce::String (static_cast<juce::int64> (profiler.getNumBlocks())) + " blocks");
+    lines.add ({});
+
+    for (int s = 0; s < BlockProfiler::numStages; ++s)
+    {
+        const auto stage = static_cast<BlockProfiler::Stage> (s);
+        const auto summary = profiler.getStageSummary (stage);
+        lines.add (juce::String (BlockProfiler::getStageName (stage)).paddedRight (' ', 12)
+                   + "mean " + juce::String (summary.meanMicroseconds, 1) + " us   p99 < "
+                   + juce::String (summary.p99Microseconds, 0) + " us");
+    }
+
     g.setColour (juce::Colours::white);
     g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    auto area = getLocalBounds().reduced (20);
+    area.removeFromBottom (30);
+    g.drawFittedText (lines.joinIntoString ("\n"), area, juce::Justification::centredLeft, lines.size());
+}
+
+void SuperautotuneAudioProcessorEditor::timerCallback()
+{
+    repaint();
 }
 
 void SuperautotuneAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
+    captureButton.setBounds (getLocalBounds().reduced (20).removeFromBottom (24));
 }
@@ -14,7 +14,8 @@
 //==============================================================================
 /**
 */
-class SuperautotuneAudioProcessorEditor  : public juce::AudioProcessorEditor
+class SuperautotuneAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                           private juce::Timer
 {
 public:
     SuperautotuneAudioProcessorEditor (SuperautotuneAudioProcessor&);
@@ -25,9 +26,15 @@ public:
     void resized() override;
 
 private:
+    //repaints the cpu readout
+    void timerCallback() override;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SuperautotuneAudioProcessor& audioProcessor;
 
+    //records what the host sends into a trace for offline replay
+    juce::ToggleButton captureButton { "Capture trace" };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SuperautotuneAudioProcessorEditor)
 };
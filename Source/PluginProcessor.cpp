@@ -8,8 +8,6 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include <juce_dsp/juce_dsp.h>
-#include <cmath>
 
 
 //==============================================================================
@@ -24,13 +22,83 @@ SuperautotuneAudioProcessor::SuperautotuneAudioProcessor()
                      #endif
                        )
 #endif
+     , parameters (*this, nullptr, "PARAMETERS", createParameterLayout())
 {
+    preserveFormantsParameter = parameters.getRawParameterValue ("formants");
+    harmonyVoicesParameter = parameters.getRawParameterValue ("voices");
+    voicingGateParameter = parameters.getRawParameterValue ("gate");
+    rangeParameter = parameters.getRawParameterValue ("range");
+    rangeMinParameter = parameters.getRawParameterValue ("rangeMin");
+    rangeMaxParameter = parameters.getRawParameterValue ("rangeMax");
+    detectorParameter = parameters.getRawParameterValue ("detector");
+    guideToneParameter = parameters.getRawParameterValue ("guide");
+    guideHarmonicsParameter = parameters.getRawParameterValue ("guideHarmonics");
+    midiOutputParameter = parameters.getRawParameterValue ("midiOut");
+    midiOnsetParameter = parameters.getRawParameterValue ("midiOnset");
+    midiHysteresisParameter = parameters.getRawParameterValue ("midiHysteresis");
+    midiVelocityRangeParameter = parameters.getRawParameterValue ("midiVelocityRange");
+
+    floatEngine.setProfiler (&profiler);
+    doubleEngine.setProfiler (&profiler);
+
+    for (auto* parameter : getParameters())
+    {
+        if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+        {
+            traceParameterIds.add (withId->paramID);
+            traceParameterValues.push_back (parameters.getRawParameterValue (withId->paramID));
+        }
+    }
 }
 
 SuperautotuneAudioProcessor::~SuperautotuneAudioProcessor()
 {
 }
 
+//detection ranges in Hz, the last entry means the custom min / max parameters
+namespace
+{
+    struct VoiceRange { const char* name; float minFrequency; float maxFrequency; };
+
+    constexpr VoiceRange voiceRanges[] = {
+        { "Bass",       70.0f,  350.0f },
+        { "Baritone",   90.0f,  450.0f },
+        { "Tenor",      120.0f, 600.0f },
+        { "Alto",       160.0f, 800.0f },
+        { "Soprano",    240.0f, 1200.0f },
+        { "Instrument", 40.0f,  1500.0f },
+        { "Custom",     0.0f,   0.0f }
+    };
+
+    constexpr int numVoiceRanges = static_cast<int> (sizeof (voiceRanges) / sizeof (voiceRanges[0]));
+    constexpr int instrumentRange = numVoiceRanges - 2;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout SuperautotuneAudioProcessor::createParameterLayout()
+{
+    juce::StringArray rangeNames;
+    for (const auto& range : voiceRanges)
+        rangeNames.add (range.name);
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    layout.add (std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "formants", 1 }, "Preserve Formants", true),
+                std::make_unique<juce::AudioParameterInt> (juce::ParameterID { "voices", 1 }, "Harmony Voices", 0, AutotuneEngine<float>::maxHarmonyVoices, 0),
+                std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "gate", 1 }, "Voicing Gate", true),
+                std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "range", 1 }, "Voice Range", rangeNames, instrumentRange),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "rangeMin", 1 }, "Custom Range Min", 20.0f, 2000.0f, 80.0f),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "rangeMax", 1 }, "Custom Range Max", 20.0f, 2000.0f, 1000.0f),
+                std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { "detector", 1 }, "Detector", juce::StringArray { "Spectral Peak", "Scale Resonators" }, 0),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "guide", 1 }, "Guide Tone Level", 0.0f, 1.0f, 0.0f),
+                std::make_unique<juce::AudioParameterInt> (juce::ParameterID { "guideHarmonics", 1 }, "Guide Tone Harmonics", 1, GuideToneBank::maxPartials, 3),
+                std::make_unique<juce::AudioParameterBool> (juce::ParameterID { "midiOut", 1 }, "MIDI Output", true),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "midiOnset", 1 }, "MIDI Onset Threshold", -80.0f, 0.0f, -40.0f),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "midiHysteresis", 1 }, "MIDI Onset Hysteresis", 0.0f, 24.0f, 6.0f),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { "midiVelocityRange", 1 }, "MIDI Velocity Range", 6.0f, 80.0f, 40.0f));
+
+    return layout;
+}
+
 //==============================================================================
 const juce::String SuperautotuneAudioProcessor::getName() const
 {
@@ -64,6 +132,11 @@ bool SuperautotuneAudioProcessor::isMidiEffect() const
    #endif
 }
 
+bool SuperautotuneAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 double SuperautotuneAudioProcessor::getTailLengthSeconds() const
 {
     return 0.0;
@@ -98,12 +171,45 @@ void SuperautotuneAudioProcessor::prepareToPlay (double sampleRate, int samplesP
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    //more than two channels are spread across the process wide worker pool
+    if (getTotalNumInputChannels() <= 2)
+        workerPool.reset();
+    else if (workerPool == nullptr)
+        workerPool = ChannelWorkerPool::getShared();
+
+    floatEngine.setWorkerPool (workerPool.get());
+    doubleEngine.setWorkerPool (workerPool.get());
+
+    profiler.prepare (sampleRate);
+
+    //only the engine matching the host precision gets its buffers allocated, the
+    //parameters go in first since the range sets the chunk length and latency
+    if (isUsingDoublePrecision())
+    {
+        updateEngine (doubleEngine);
+        doubleEngine.prepare (sampleRate, samplesPerBlock, getTotalNumInputChannels());
+        engineLatency.store (doubleEngine.getLatencySamples());
+    }
+    else
+    {
+        updateEngine (floatEngine);
+        floatEngine.prepare (sampleRate, samplesPerBlock, getTotalNumInputChannels());
+        engineLatency.store (floatEngine.getLatencySamples());
+    }
+
+    traceRecorder.capturePrepare (getTraceConfig (sampleRate, samplesPerBlock));
+
+    cancelPendingUpdate();
+    setLatencySamples (engineLatency.load());
 }
 
 void SuperautotuneAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    floatEngine.setWorkerPool (nullptr);
+    doubleEngine.setWorkerPool (nullptr);
+    workerPool.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -113,12 +219,9 @@ bool SuperautotuneAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel is corrected independently, so any discrete layout works,
+    // from mono up to immersive and ambisonic buses.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -132,315 +235,130 @@ bool SuperautotuneAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
 }
 #endif
 
-void applyHammingWindow(float* data, int numSamples)
+template <typename SampleType>
+void SuperautotuneAudioProcessor::updateEngine (AutotuneEngine<SampleType>& engine)
 {
-    for (int i = 0; i < numSamples; ++i)
-    {
-        // Apply the Hamming window
-        data[i] *= 0.54f - 0.46f * cosf(2.0f * juce::MathConstants<float>::pi * i / (numSamples - 1));
-    }
+    engine.preserveFormants = preserveFormantsParameter->load() >= 0.5f;
+    engine.numHarmonyVoices = static_cast<int> (harmonyVoicesParameter->load());
+    engine.gateEnabled = voicingGateParameter->load() >= 0.5f;
+    engine.detector = detectorParameter->load() >= 0.5f ? AutotuneEngine<SampleType>::Detector::resonatorBank
+                                                        : AutotuneEngine<SampleType>::Detector::spectralPeak;
+    engine.guideToneLevel = guideToneParameter->load();
+    engine.guideToneHarmonics = static_cast<int> (guideHarmonicsParameter->load());
+    engine.midiOutputEnabled = midiOutputParameter->load() >= 0.5f;
+    engine.midiOutput.onsetThresholdDb = midiOnsetParameter->load();
+    engine.midiOutput.hysteresisDb = midiHysteresisParameter->load();
+    engine.midiOutput.velocityRangeDb = midiVelocityRangeParameter->load();
+
+    const int range = juce::jlimit (0, numVoiceRanges - 1, static_cast<int> (rangeParameter->load()));
+    if (range == numVoiceRanges - 1)
+        engine.setRange (rangeMinParameter->load(), rangeMaxParameter->load());
+    else
+        engine.setRange (voiceRanges[range].minFrequency, voiceRanges[range].maxFrequency);
 }
 
-void applyBlackmanHarrisWindow(float* data, int numSamples)
+template <typename SampleType>
+void SuperautotuneAudioProcessor::checkLatency (const AutotuneEngine<SampleType>& engine)
 {
-    for (int i = 0; i < numSamples; ++i)
-    {
-        // Apply the Blackman-Harris window
-        float a0 = 0.35875f;
-        float a1 = 0.48829f;
-        float a2 = 0.14128f;
-        float a3 = 0.01168f;
-        
-        data[i] *= a0 - a1 * cosf(2.0f * juce::MathConstants<float>::pi * i / (numSamples - 1))
-                      + a2 * cosf(4.0f * juce::MathConstants<float>::pi * i / (numSamples - 1))
-                      - a3 * cosf(6.0f * juce::MathConstants<float>::pi * i / (numSamples - 1));
-    }
-}
+    const int latency = engine.getLatencySamples();
 
+    if (engineLatency.exchange (latency) != latency || engine.getRequestedOrder() > 0)
+        triggerAsyncUpdate();
+}
 
-float lastphase = 0;
-float lastFreq = -1;
-
-class Scale {
-    public:
-    //first arg: an array of frequency ratios for the scale
-    //2nd arg: home frequency of the scale
-    Scale(const std::vector<float>& values, float freq) : scale(values), baseFrequency(reduceF(freq)) {}
+void SuperautotuneAudioProcessor::handleAsyncUpdate()
+{
+    const int requestedOrder = isUsingDoublePrecision() ? doubleEngine.getRequestedOrder()
+                                                        : floatEngine.getRequestedOrder();
 
-    float findNote(float inputFreq)
-    {
-        if(inputFreq == 0)
-        {
-            return 0.0f;
-        }
-        float minDifference = 120000000000;
-        int scaleIndex;
-        int power;
-        float relativeFrequency;
-        float octave;
-        for (size_t i = 0; i < scale.size(); ++i)
-        {
-            for(int p = 0; p < 10; ++p){
-                octave = baseFrequency*std::pow(2, p);
-                float difference = std::abs(1200*log2(inputFreq/(octave*scale[i])));
-                if (difference<minDifference)
-                {
-                    minDifference = difference;
-                    scaleIndex = i;
-                    relativeFrequency = baseFrequency*std::pow(2, p);
-
-                }
-            }
-        }
-        float outputNote = relativeFrequency * scale[scaleIndex];
-        return outputNote;
-    }
-    private:
-        float reduceF(float freq)
+    //building the ffts allocates, so the engine sits out the blocks that takes
+    if (requestedOrder > 0)
     {
-        while(freq > 30)
-        {
-            freq/=2;
-        }
-        return freq;
+        suspendProcessing (true);
+        prepareAnalysisOrder (requestedOrder);
+        suspendProcessing (false);
     }
-    float baseFrequency;
-    std::vector<float> scale;
-};
-
-std::vector<float> _5lim = {9.0f/8.0f, 5.0f/4.0f, 4.0f/3.0f, 3.0f/2.0f, 5.0f/3.0f, 15.0f/8.0f, 2.0f/1.0f};
-Scale _5lim_500hz(_5lim, 500);  
-
-struct oscillator{
-    float frequency;
-    float phase = 0.0f;
-};
-
 
+    setLatencySamples (engineLatency.load());
+}
 
-void SuperautotuneAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void SuperautotuneAudioProcessor::prepareAnalysisOrder (int order)
 {
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-    float sampleRate = getSampleRate();
-int order = 1+std::ceil(std::log2(buffer.getNumSamples()));
-juce::dsp::FFT fft(order);
-static oscillator osc1;
-static oscillator osc2;
-//output
-std::vector<std::complex<float>> fft_in(1 << order, {0.0f, 0.0f});
-std::vector<std::complex<float>> fft_out(1 << order, {0.0f, 0.0f});
-std::vector<float> phases(pow(2,order), 0.0f);
-
-bool phaseSet = false;
+    if (isUsingDoublePrecision())
+        doubleEngine.prepareOrder (order);
+    else
+        floatEngine.prepareOrder (order);
 
+    traceRecorder.captureOrder (order);
+}
 
+bool SuperautotuneAudioProcessor::restoreEngineState (const void* data, size_t numBytes)
+{
+    StateReader reader (data, numBytes);
 
+    if (isUsingDoublePrecision())
+        doubleEngine.visitState (reader);
+    else
+        floatEngine.visitState (reader);
 
+    return reader.succeeded();
+}
 
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+TraceRecorder::Config SuperautotuneAudioProcessor::getTraceConfig (double sampleRate, int blockSize) const
+{
+    const int analysisOrder = isUsingDoublePrecision() ? doubleEngine.getPreparedOrder()
+                                                       : floatEngine.getPreparedOrder();
 
+    return { sampleRate, blockSize, getTotalNumInputChannels(), isUsingDoublePrecision(), analysisOrder };
+}
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
+void SuperautotuneAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
 
+    //taken first so the capture's copy counts towards the block's load
+    const auto blockStart = juce::Time::getHighResolutionTicks();
 
+    traceRecorder.captureBlock (buffer, midiMessages, traceParameterValues.data(), static_cast<int> (traceParameterValues.size()), floatEngine);
 
-    if (buffer.getNumChannels() != 0 && buffer.getNumSamples() != 0)
-    {
-        for (int channel = 1; channel < totalNumInputChannels; ++channel)
-        {
-std::cout << "263" << std::endl;
-int numSamples = buffer.getNumSamples();
-auto* channelData = buffer.getWritePointer(channel);
+    updateEngine (floatEngine);
+    floatEngine.process (buffer, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    floatEngine.writeMidi (midiMessages);
+    checkLatency (floatEngine);
 
-auto nextPhaseLambda = [numSamples, sampleRate](float frequency, float phase) -> float
-{
-    // phase increment per sample
-    float phaseIncrement = 2 * M_PI * frequency / sampleRate;
-    int samplesLeft = numSamples - static_cast<int>(phase * numSamples / (2 * M_PI));
-    phase += phaseIncrement * samplesLeft;
-    
-    if (phase >= M_PI)
-        phase -= 2 * M_PI;
-    else if (phase < -1 * M_PI)
-        phase += 2 * M_PI;
+    traceRecorder.captureOutput (buffer, midiMessages);
 
-    return phase;
-};
+    profiler.endBlock (buffer.getNumSamples(), juce::Time::getHighResolutionTicks() - blockStart);
+}
 
-auto sinc = [](float x) -> float
+void SuperautotuneAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
 {
-    if (x == 0.0f) return 1.0f;
-    return sin(M_PI * x) / (M_PI * x);
-};
+    juce::ScopedNoDenormals noDenormals;
 
+    //taken first so the capture's copy counts towards the block's load
+    const auto blockStart = juce::Time::getHighResolutionTicks();
 
+    traceRecorder.captureBlock (buffer, midiMessages, traceParameterValues.data(), static_cast<int> (traceParameterValues.size()), doubleEngine);
 
+    updateEngine (doubleEngine);
+    doubleEngine.process (buffer, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    doubleEngine.writeMidi (midiMessages);
+    checkLatency (doubleEngine);
 
-auto oscillate = [&channelData, sampleRate, numSamples](oscillator& osc) {
+    traceRecorder.captureOutput (buffer, midiMessages);
 
-    float phase = osc.phase;
-    float frequency = osc.frequency;
+    profiler.endBlock (buffer.getNumSamples(), juce::Time::getHighResolutionTicks() - blockStart);
+}
 
-    for (int i = 0; i < numSamples; ++i) 
-    {
-        // Create the sine wave of the strongest frequency
-        phase += juce::MathConstants<float>::pi * frequency / sampleRate;
-        phase = std::fmod(phase, 2.0f * juce::MathConstants<float>::pi);
-        channelData[i] += sin(phase);  // Directly assign the sine wave value to channelData
-    }
-    osc.phase = phase;  // Update oscillator phase after processing
-    };
+//==============================================================================
+bool SuperautotuneAudioProcessor::startTraceCapture (const juce::File& file)
+{
+    return traceRecorder.start (file, getTraceConfig (getSampleRate(), getBlockSize()), traceParameterIds);
+}
 
-            if (channelData == nullptr) {
-                DBG("Error: channelData pointer is null!");
-                return;
-            }
-            else {
-                
-std::cout << "306" << std::endl;
-                std::vector<float> fftData(static_cast<size_t>(pow(2, order + 1)), 0.0f);
-std::cout << "308" << std::endl;
-                for (size_t i = 0; i < buffer.getNumSamples(); ++i) {
-                    // hamming window
-                    //float windowValue = 0.54f - 0.46f * std::cos(2.0f * M_PI * i / (buffer.getNumSamples() - 1));
-                    //copy windowed buffer samples into fft complex array
-                    fft_in[i] = std::complex<float>(channelData[i], 0.0f);
-                    fftData[i] = channelData[i];
-                }
-
-
-                //fill output with bins
-                fft.perform(fft_in.data(), fft_out.data(), false);
-
-           std::cout << "321" << std::endl;     
-                //fft.performFrequencyOnlyForwardTransform(fftData.data());
-                //get bin with max magnitude
-
-                float maxMagnitude = 0.0f;
-                int maxBin = -1;
-                float maxFreq = 1500;
-                int maxBinIndex = static_cast<int>((2 * maxFreq / sampleRate) * fft_out.size());
-
-                for (int i = 0; i < maxBinIndex; ++i)
-                {
-                    if (std::abs(fft_out[i]) > maxMagnitude)
-                    {
-                        maxMagnitude = std::abs(fft_out[i]);
-                        maxBin = i;
-                    }
-                }
-
-                // Calculate frequency and print it
-                float frequency = 2 * (maxBin * sampleRate) / fft_out.size();
-                
-                std::cout << "Frequency before scale: " << frequency << " Hz" << std::endl;
-
-            
-                //idk why but sometimes frequency is negative on startup
-                if(frequency < 0){
-                    frequency = 0;
-                }
-
-                //clear the buffer
-                std::fill(channelData, channelData + buffer.getNumSamples(), 0.0f);
-
-                //map to scale
-                float newFrequency = _5lim_500hz.findNote(frequency);
-                float correctionRatio = newFrequency/frequency;
-                //correctionRatio = 1;
-
-                //change pitch
-                std::vector<std::complex<float>> shifted_bins(fft_out.size(), {0.0f, 0.0f});
-
-                for(int bin = 0; bin < fft_out.size(); ++bin)
-                {
-                    float binFrequency = static_cast<float>(bin) * (sampleRate / fft_out.size());
-                    float shiftedFrequency = 2*binFrequency * correctionRatio;
-                    //shifted_bins[bin] = fft_out[bin];
-                        //phases[bin] = nextPhaseLambda(shiftedFrequency, phases[bin]);
-                    
-                    float shiftedBin = correctionRatio * static_cast<float>(bin);
-
-
-                    //no interpolation
-                    //int intShiftedBin = static_cast<int>(shiftedBin);
-                    //intShiftedBin = bin;
-
-                    int intShiftedBinLow = static_cast<int>(std::floor(shiftedBin));
-                    int intShiftedBinHigh = intShiftedBinLow + 1;
-
-                    float distanceLow = shiftedBin - intShiftedBinLow;
-                    float distanceHigh = 1.0f - distanceLow;
-
-                    float weightLow = sinc(distanceLow);
-                    float weightHigh = sinc(distanceHigh);
-
-                    if (intShiftedBinLow < fft_out.size()) 
-                    {
-                        shifted_bins[intShiftedBinLow] = fft_out[bin] * weightLow;
-                        phases[intShiftedBinLow] = nextPhaseLambda(shiftedFrequency, phases[bin]);
-                    }
-
-                    if (intShiftedBinHigh < fft_out.size()) 
-                    {
-                        shifted_bins[intShiftedBinHigh] = fft_out[bin] * weightHigh;
-                    }
-                    
-/*
-                    if (intShiftedBin < fft_out.size())
-                    {
-
-                        shifted_bins[intShiftedBin] = std::complex<float> {fft_out[bin].real(),phases[intShiftedBin]};
-                        phases[intShiftedBin] = nextPhaseLambda(shiftedFrequency, phases[bin]);
-                        //shifted_bins[fftData.size() - intShiftedBin - 1] = std::conj(shifted_bins[intShiftedBin]);
-                    }*/
-                }
-                //shifted_bins = fft_out;
-
-                
-                //test: put fft data back into buffer
-                fft.perform(shifted_bins.data(), fft_out.data(), true);
-                
-                for (size_t i = 0; i < buffer.getNumSamples(); ++i) 
-                {
-                    channelData[i] = std::abs(fft_out[i]);
-                }
-                std::cout << channelData[buffer.getNumSamples()-1] <<std::endl;
-
-                /* SIMPLE OSCILLATION
-                //map to scale
-                frequency = _5lim_500hz.findNote(frequency);
-                std::cout << "Frequency after scale: " << frequency << " Hz" << std::endl;
-
-                if (frequency != lastFreq) {
-                    
-                    osc1.frequency = frequency;
-                }
-                
-                oscillate(osc1);
-
-
-                lastFreq = frequency;
-
-                */
-            }
-            
-        }
-    }
+void SuperautotuneAudioProcessor::stopTraceCapture()
+{
+    traceRecorder.stop();
 }
 
 //==============================================================================
@@ -460,12 +378,17 @@ void SuperautotuneAudioProcessor::getStateInformation (juce::MemoryBlock& destDa
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
+    if (auto xml = parameters.copyState().createXml())
+        copyXmlToBinary (*xml, destData);
 }
 
 void SuperautotuneAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    if (auto xml = getXmlFromBinary (data, sizeInBytes))
+        if (xml->hasTagName (parameters.state.getType()))
+            parameters.replaceState (juce::ValueTree::fromXml (*xml));
 }
 
 //==============================================================================
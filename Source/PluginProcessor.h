@@ -9,11 +9,14 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AutotuneEngine.h"
+#include "TraceRecorder.h"
 
 //==============================================================================
 /**
 */
-class SuperautotuneAudioProcessor  : public juce::AudioProcessor
+class SuperautotuneAudioProcessor  : public juce::AudioProcessor,
+                                     private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -29,6 +32,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -53,7 +58,74 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    juce::AudioProcessorValueTreeState parameters;
+
+    //per stage and per block cpu cost since the last prepareToPlay
+    BlockProfiler& getProfiler() noexcept { return profiler; }
+
+    //opt-in capture of every block the host sends, for TraceReplay. Message thread only
+    bool startTraceCapture (const juce::File& file);
+    void stopTraceCapture();
+    bool isCapturingTrace() const noexcept { return traceRecorder.isCapturing(); }
+
+    //builds the ffts for a range below the prepared ones, which is what the message
+    //thread does when the engine asks for them, and what a replay does where the
+    //capture did. Never while processBlock can run
+    void prepareAnalysisOrder (int order);
+
+    //puts the engine back in the state a capture started from, which is what a replay
+    //does at the capture's state record. False when the state doesn't match how the
+    //engine was prepared. Never while processBlock can run
+    bool restoreEngineState (const void* data, size_t numBytes);
+
 private:
     //==============================================================================
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    //pushes the current parameter values into an engine at the top of each block
+    template <typename SampleType>
+    void updateEngine (AutotuneEngine<SampleType>& engine);
+
+    //the range sets the engine's chunk length and so its latency, a change made
+    //while playing is reported to the host from the message thread, which also
+    //builds the ffts of a range below the prepared ones
+    template <typename SampleType>
+    void checkLatency (const AutotuneEngine<SampleType>& engine);
+    void handleAsyncUpdate() override;
+    std::atomic<int> engineLatency { 0 };
+
+    //the prepare settings and the engine's prepared fft order, as a trace records them
+    TraceRecorder::Config getTraceConfig (double sampleRate, int blockSize) const;
+
+    std::atomic<float>* preserveFormantsParameter = nullptr;
+    std::atomic<float>* harmonyVoicesParameter = nullptr;
+    std::atomic<float>* voicingGateParameter = nullptr;
+    std::atomic<float>* rangeParameter = nullptr;
+    std::atomic<float>* rangeMinParameter = nullptr;
+    std::atomic<float>* rangeMaxParameter = nullptr;
+    std::atomic<float>* detectorParameter = nullptr;
+    std::atomic<float>* guideToneParameter = nullptr;
+    std::atomic<float>* guideHarmonicsParameter = nullptr;
+    std::atomic<float>* midiOutputParameter = nullptr;
+    std::atomic<float>* midiOnsetParameter = nullptr;
+    std::atomic<float>* midiHysteresisParameter = nullptr;
+    std::atomic<float>* midiVelocityRangeParameter = nullptr;
+
+    //every parameter's raw value in a fixed order, as the trace records them
+    juce::StringArray traceParameterIds;
+    std::vector<std::atomic<float>*> traceParameterValues;
+    TraceRecorder traceRecorder;
+
+    //declared before the engines, they keep a pointer to it
+    BlockProfiler profiler;
+
+    AutotuneEngine<float> floatEngine;
+    AutotuneEngine<double> doubleEngine;
+
+    //shared with every other instance, declared after the engines so this
+    //instance lets go of it before they're destroyed
+    std::shared_ptr<ChannelWorkerPool> workerPool;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SuperautotuneAudioProcessor)
 };
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    ResonatorBank.cpp
+
+  ==============================================================================
+*/
+
+#include "ResonatorBank.h"
+#include <cmath>
+#include <complex>
+
+void ResonatorBank::prepare (int maxResonators)
+{
+    const size_t groups = static_cast<size_t> ((maxResonators + lanes - 1) / lanes);
+    re.reserve (groups);
+    im.reserve (groups);
+    startRe.reserve (groups);
+    startIm.reserve (groups);
+    coefRe.reserve (groups);
+    coefIm.reserve (groups);
+
+    notes.reserve (static_cast<size_t> (maxResonators));
+    normalisation.reserve (static_cast<size_t> (maxResonators));
+    magnitudes.reserve (static_cast<size_t> (maxResonators));
+    phaseAdvance.reserve (static_cast<size_t> (maxResonators));
+}
+
+void ResonatorBank::reset()
+{
+    std::fill (re.begin(), re.end(), Vec::expand (0.0f));
+    std::fill (im.begin(), im.end(), Vec::expand (0.0f));
+    note = 0.0f;
+    frequency = 0.0f;
+}
+
+void ResonatorBank::setFrequencies (const float* newNotes, int numNotes, double newSampleRate)
+{
+    jassert (static_cast<size_t> (numNotes) <= notes.capacity());
+
+    sampleRate = newSampleRate;
+    numResonators = numNotes;
+
+    const size_t groups = static_cast<size_t> ((numNotes + lanes - 1) / lanes);
+    re.assign (groups, Vec::expand (0.0f));
+    im.assign (groups, Vec::expand (0.0f));
+    startRe.assign (groups, Vec::expand (0.0f));
+    startIm.assign (groups, Vec::expand (0.0f));
+    coefRe.assign (groups, Vec::expand (0.0f));
+    coefIm.assign (groups, Vec::expand (0.0f));
+
+    notes.assign (newNotes, newNotes + numNotes);
+    normalisation.assign (static_cast<size_t> (numNotes), 0.0f);
+    magnitudes.assign (static_cast<size_t> (numNotes), 0.0f);
+    phaseAdvance.assign (static_cast<size_t> (numNotes), 0.0);
+
+    for (int k = 0; k < numNotes; ++k)
+    {
+        const double omega = juce::MathConstants<double>::twoPi * notes[k] / sampleRate;
+        const double decay = std::exp (-juce::MathConstants<double>::pi * bandwidthRatio * notes[k] / sampleRate);
+
+        //padding lanes keep a zero coefficient and are never read back
+        const size_t g = static_cast<size_t> (k / lanes);
+        const size_t lane = static_cast<size_t> (k % lanes);
+        coefRe[g].set (lane, static_cast<float> (decay * std::cos (omega)));
+        coefIm[g].set (lane, static_cast<float> (decay * std::sin (omega)));
+
+        //peak gain of a leaky resonator is 1 / (1 - decay)
+        normalisation[k] = static_cast<float> (1.0 - decay);
+    }
+
+    note = 0.0f;
+    frequency = 0.0f;
+}
+
+void ResonatorBank::accumulatePhase (int spanSamples)
+{
+    for (int k = 0; k < numResonators; ++k)
+    {
+        const size_t g = static_cast<size_t> (k / lanes);
+        const size_t lane = static_cast<size_t> (k % lanes);
+        const std::complex<float> start { startRe[g].get (lane), startIm[g].get (lane) };
+        const std::complex<float> end { re[g].get (lane), im[g].get (lane) };
+
+        //unwrap around the advance the resonator's own note would give over the span
+        const double expected = juce::MathConstants<double>::twoPi * notes[k] * spanSamples / sampleRate;
+        const double measured = std::arg (end * std::conj (start));
+        phaseAdvance[k] += expected + std::remainder (measured - expected, juce::MathConstants<double>::twoPi);
+    }
+}
+
+float ResonatorBank::measureFrequency (int k, int numSamples) const
+{
+    return static_cast<float> (phaseAdvance[k] * sampleRate / (juce::MathConstants<double>::twoPi * numSamples));
+}
+
+void ResonatorBank::decide (int numSamples)
+{
+    int loudest = -1;
+    float loudestMagnitude = silenceMagnitude;
+
+    for (int k = 0; k < numResonators; ++k)
+    {
+        const size_t g = static_cast<size_t> (k / lanes);
+        const size_t lane = static_cast<size_t> (k % lanes);
+        const float r = re[g].get (lane);
+        const float i = im[g].get (lane);
+        magnitudes[k] = std::sqrt (r * r + i * i) * normalisation[k];
+
+        if (magnitudes[k] > loudestMagnitude)
+        {
+            loudestMagnitude = magnitudes[k];
+            loudest = k;
+        }
+    }
+
+    if (loudest < 0 || numSamples <= 0)
+    {
+        note = 0.0f;
+        frequency = 0.0f;
+        return;
+    }
+
+    //the loudest resonator may sit on a harmonic, look for a strong enough note
+    //under the lowest subharmonic first
+    const float loudestFrequency = measureFrequency (loudest, numSamples);
+    int winner = loudest;
+
+    for (int harmonic = 4; harmonic >= 2 && winner == loudest; --harmonic)
+    {
+        const float target = loudestFrequency / static_cast<float> (harmonic);
+
+        for (int k = 0; k < loudest; ++k)
+        {
+            const bool isNear = std::abs (1200.0f * std::log2 (notes[k] / target)) < subharmonicCents;
+
+            if (isNear && magnitudes[k] >= fundamentalRatio * loudestMagnitude)
+            {
+                winner = k;
+                break;
+            }
+        }
+    }
+
+    note = notes[winner];
+    frequency = winner == loudest ? loudestFrequency : measureFrequency (winner, numSamples);
+
+    //a resonator still ringing up, or pushed around by noise, can turn backwards
+    //over a block, that's no pitch to correct from
+    if (frequency <= 0.0f)
+    {
+        note = 0.0f;
+        frequency = 0.0f;
+    }
+}
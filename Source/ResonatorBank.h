@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    ResonatorBank.h
+
+    Scale-tuned detector: one damped complex resonator (a leaky sliding DFT
+    bin) on every scale note inside the voice range, updated per sample with
+    SIMD across resonators. It answers "which scale note is closest" at a
+    cost that grows with the number of notes, not with the fft size. The
+    answer is decided once per processed block, so it lags the input by the
+    engine's chunk like the spectral detector does.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <vector>
+
+class ResonatorBank
+{
+public:
+    //reserves room for maxResonators so retuning never allocates
+    void prepare (int maxResonators);
+    void reset();
+
+    //the tuning and every resonator's ringing state, see StateArchive.h
+    template <typename Archive>
+    void visitState (Archive& archive)
+    {
+        archive.vector (re);
+        archive.vector (im);
+        archive.vector (coefRe);
+        archive.vector (coefIm);
+        archive.vector (notes);
+        archive.vector (normalisation);
+        archive.value (numResonators);
+        archive.value (sampleRate);
+        archive.value (note);
+        archive.value (frequency);
+        archive.check (notes.size() == static_cast<size_t> (numResonators) && normalisation.size() == notes.size()
+                         && re.size() == coefRe.size() && im.size() == re.size() && coefIm.size() == re.size());
+
+        //the per block scratch follows the restored tuning
+        if (archive.isRestoring())
+        {
+            startRe.resize (re.size());
+            startIm.resize (re.size());
+            magnitudes.resize (notes.size());
+            phaseAdvance.resize (notes.size());
+        }
+    }
+
+    //retunes the bank, notes must be sorted ascending and fit the prepared size
+    void setFrequencies (const float* notes, int numNotes, double sampleRate);
+
+    template <typename SampleType>
+    void process (const SampleType* data, int numSamples)
+    {
+        std::fill (phaseAdvance.begin(), phaseAdvance.end(), 0.0);
+
+        for (int spanStart = 0; spanStart < numSamples; spanStart += measureSpan)
+        {
+            const int spanSamples = juce::jmin (measureSpan, numSamples - spanStart);
+
+            std::copy (re.begin(), re.end(), startRe.begin());
+            std::copy (im.begin(), im.end(), startIm.begin());
+
+            for (int i = spanStart; i < spanStart + spanSamples; ++i)
+            {
+                const auto x = Vec::expand (static_cast<float> (data[i]));
+
+                for (size_t g = 0; g < re.size(); ++g)
+                {
+                    const auto newRe = coefRe[g] * re[g] - coefIm[g] * im[g] + x;
+                    im[g] = coefRe[g] * im[g] + coefIm[g] * re[g];
+                    re[g] = newRe;
+                }
+            }
+
+            accumulatePhase (spanSamples);
+        }
+
+        decide (numSamples);
+    }
+
+    //scale note of the strongest fundamental, 0 when nothing rings
+    float getNote() const      { return note; }
+
+    //instantaneous frequency of the winning resonator, the actual sung pitch. 0,
+    //together with the note, when the block is unpitched: nothing rings above the
+    //silence floor (quiet frames, onsets while the resonators ramp up) or no
+    //positive frequency could be measured. Callers must leave such a block uncorrected
+    float getFrequency() const { return frequency; }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = static_cast<int> (Vec::SIMDNumElements);
+
+    void decide (int numSamples);
+
+    //adds each resonator's unwrapped phase advance over the span just processed
+    void accumulatePhase (int spanSamples);
+
+    //average frequency over the last block from the phase advance of resonator k
+    float measureFrequency (int k, int numSamples) const;
+
+    std::vector<Vec> re, im, coefRe, coefIm;
+    std::vector<Vec> startRe, startIm;
+    std::vector<float> notes, normalisation, magnitudes;
+    std::vector<double> phaseAdvance;
+    int numResonators = 0;
+    double sampleRate = 44100.0;
+
+    float note = 0.0f;
+    float frequency = 0.0f;
+
+    //constant-Q bandwidth, about a quarter tone either side
+    static constexpr float bandwidthRatio = 0.03f;
+
+    //a note near a half, third or quarter of the loudest frequency wins if it's at least
+    //this strong, otherwise harmonics would be picked over the fundamental
+    static constexpr float fundamentalRatio = 0.4f;
+    static constexpr float subharmonicCents = 100.0f;
+    static constexpr float silenceMagnitude = 1.0e-4f;
+
+    //phase is unwrapped every measureSpan samples, which holds while the input stays
+    //within sampleRate / (2 * measureSpan) of a resonator's note (375 Hz at 12 kHz)
+    //however long the block is
+    static constexpr int measureSpan = 16;
+};
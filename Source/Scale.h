@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    Scale.h
+
+    Quantizes a detected frequency to the nearest degree of a just-intonation
+    scale. Templated on the sample type so each engine precision gets its own.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include "SharedTables.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+template <typename SampleType>
+class Scale {
+    public:
+    //first arg: an array of frequency ratios for the scale
+    //2nd arg: home frequency of the scale
+    //the note table is shared with every other instance using the same scale
+    Scale(const std::vector<SampleType>& values, SampleType freq)
+        : table(SharedTables::getScaleTable(values, reduceF(freq), numOctaves)) {}
+
+    SampleType findNote(SampleType inputFreq) const
+    {
+        if(inputFreq == 0)
+        {
+            return SampleType(0);
+        }
+        return table->notes[nearestIndex(inputFreq)];
+    }
+
+    //the scale note degreeOffset steps away from the note nearest to inputFreq,
+    //used to stack harmonies on top of (or below) the corrected lead
+    SampleType findHarmony(SampleType inputFreq, int degreeOffset) const
+    {
+        if(inputFreq == 0 || table->notes.empty())
+        {
+            return SampleType(0);
+        }
+        const int lastDegree = static_cast<int>(table->notes.size()) - 1;
+        int degree = std::clamp(static_cast<int>(nearestIndex(inputFreq)) + degreeOffset, 0, lastDegree);
+        return table->notes[static_cast<size_t>(degree)];
+    }
+    //every scale note between minFreq and maxFreq, ascending, at most maxNotes of them
+    void notesInRange(SampleType minFreq, SampleType maxFreq, std::vector<float>& notes, int maxNotes) const
+    {
+        notes.clear();
+        for (auto note : table->notes)
+        {
+            if (note >= minFreq && note <= maxFreq && static_cast<int>(notes.size()) < maxNotes)
+            {
+                notes.push_back(static_cast<float>(note));
+            }
+        }
+    }
+    private:
+    static constexpr int numOctaves = 10;
+
+    static SampleType reduceF(SampleType freq)
+    {
+        while(freq > 30)
+        {
+            freq/=2;
+        }
+        return freq;
+    }
+
+    //nearest note in cents is nearest in log2, so a binary search over the table
+    size_t nearestIndex(SampleType inputFreq) const
+    {
+        const auto& log2Notes = table->log2Notes;
+        if (log2Notes.empty())
+        {
+            return 0;
+        }
+        const SampleType target = std::log2(inputFreq);
+        auto above = std::lower_bound(log2Notes.begin(), log2Notes.end(), target);
+        if (above == log2Notes.begin())
+        {
+            return 0;
+        }
+        if (above == log2Notes.end() || target - *(above - 1) <= *above - target)
+        {
+            --above;
+        }
+        return static_cast<size_t>(above - log2Notes.begin());
+    }
+
+    std::shared_ptr<const ScaleTable<SampleType>> table;
+};
+
+//5-limit just major scale
+template <typename SampleType>
+std::vector<SampleType> fiveLimitRatios()
+{
+    return { SampleType(9.0/8.0), SampleType(5.0/4.0), SampleType(4.0/3.0), SampleType(3.0/2.0),
+             SampleType(5.0/3.0), SampleType(15.0/8.0), SampleType(2.0/1.0) };
+}
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    SharedTables.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedTables.h"
+#include <cmath>
+
+SincKernel::SincKernel (int newResolution)
+    : resolution (juce::jmax (newResolution, 1)),
+      values (static_cast<size_t> (resolution + 1))
+{
+    for (int i = 0; i <= resolution; ++i)
+    {
+        const double x = static_cast<double> (i) / resolution;
+        values[static_cast<size_t> (i)] = x == 0.0 ? 1.0f
+                                                   : static_cast<float> (std::sin (M_PI * x) / (M_PI * x));
+    }
+}
+
+std::mutex& SharedTables::getMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::shared_ptr<const SincKernel> SharedTables::getSincKernel (int resolution)
+{
+    static std::map<int, std::weak_ptr<const SincKernel>> kernels;
+
+    return acquire (kernels, resolution, [resolution]
+    {
+        return std::make_shared<const SincKernel> (resolution);
+    });
+}
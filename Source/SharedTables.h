@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    SharedTables.h
+
+    Process wide registry of the immutable tables every engine needs: the
+    compiled scale note tables and the sinc interpolation kernel. Tables are
+    reference counted, built the first time an instance asks for one and
+    freed when the last instance using it lets go, so a session with many
+    instances only holds one copy of each. FFT objects aren't shared, JUCE's
+    fallback FFT serialises perform() on an internal lock, so every engine
+    owns its own.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_dsp/juce_dsp.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+//every note of a scale over the ten octaves Scale searches, ascending, with
+//the log2 of each note alongside so the nearest note is a binary search
+template <typename SampleType>
+struct ScaleTable
+{
+    std::vector<SampleType> notes;
+    std::vector<SampleType> log2Notes;
+};
+
+//sin(pi x) / (pi x) sampled over [0, 1], read with linear interpolation
+class SincKernel
+{
+public:
+    explicit SincKernel (int resolution);
+
+    float operator() (float x) const noexcept
+    {
+        const float position = juce::jlimit (0.0f, 1.0f, x) * static_cast<float> (resolution);
+        const int index = juce::jmin (static_cast<int> (position), resolution - 1);
+        const float fraction = position - static_cast<float> (index);
+        return values[static_cast<size_t> (index)]
+             + fraction * (values[static_cast<size_t> (index + 1)] - values[static_cast<size_t> (index)]);
+    }
+
+private:
+    int resolution;
+    std::vector<float> values;
+};
+
+class SharedTables
+{
+public:
+    //lookups lock the registry and may build a table, call them from prepare or
+    //a constructor, never from the audio thread
+    static std::shared_ptr<const SincKernel> getSincKernel (int resolution = defaultSincResolution);
+
+    template <typename SampleType>
+    static std::shared_ptr<const ScaleTable<SampleType>> getScaleTable (const std::vector<SampleType>& ratios,
+                                                                        SampleType baseFrequency, int numOctaves);
+
+    static constexpr int defaultSincResolution = 4096;
+
+private:
+    //returns the live table for key, or builds one with create and remembers it
+    //weakly so it goes away with its last user, entries whose table went away are
+    //dropped on the way so keys that are no longer used don't pile up
+    template <typename Key, typename Table, typename Factory>
+    static std::shared_ptr<const Table> acquire (std::map<Key, std::weak_ptr<const Table>>& tables,
+                                                 const Key& key, Factory&& create)
+    {
+        const std::lock_guard<std::mutex> lock (getMutex());
+
+        for (auto it = tables.begin(); it != tables.end();)
+            it = it->second.expired() ? tables.erase (it) : std::next (it);
+
+        if (auto existing = tables[key].lock())
+            return existing;
+
+        std::shared_ptr<const Table> table = create();
+        tables[key] = table;
+        return table;
+    }
+
+    static std::mutex& getMutex();
+};
+
+template <typename SampleType>
+std::shared_ptr<const ScaleTable<SampleType>> SharedTables::getScaleTable (const std::vector<SampleType>& ratios,
+                                                                           SampleType baseFrequency, int numOctaves)
+{
+    using Key = std::tuple<std::vector<SampleType>, SampleType, int>;
+    static std::map<Key, std::weak_ptr<const ScaleTable<SampleType>>> tables;
+
+    return acquire (tables, Key { ratios, baseFrequency, numOctaves }, [&]
+    {
+        auto table = std::make_shared<ScaleTable<SampleType>>();
+
+        for (int p = 0; p < numOctaves; ++p)
+        {
+            for (auto ratio : ratios)
+            {
+                const SampleType note = baseFrequency * std::pow (SampleType (2), p) * ratio;
+                table->notes.push_back (note);
+                table->log2Notes.push_back (std::log2 (note));
+            }
+        }
+
+        return table;
+    });
+}
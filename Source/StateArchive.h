@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    StateArchive.h
+
+    Byte image of the dsp state the next block starts from, so a trace replay
+    can pick up a capture that began while the engine was already running.
+    Every class holding such state lists it once, in a visitState (Archive&)
+    template, and the same list measures, saves and restores it:
+
+        StateSizer   counts the bytes, so the recorder can claim them up front
+        StateWriter  copies the state out through a sink's write (data, bytes),
+                     never allocates, so it can run on the audio thread
+        StateReader  copies it back, resizing vectors to their saved length
+
+    Scratch that every block overwrites before reading is left out.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+class StateSizer
+{
+public:
+    static constexpr bool isRestoring() noexcept { return false; }
+    bool isValid() const noexcept                { return true; }
+
+    template <typename Type>
+    void value (const Type&) noexcept
+    {
+        static_assert (std::is_trivially_copyable<Type>::value, "state is saved as raw bytes");
+        numBytes += sizeof (Type);
+    }
+
+    template <typename Type>
+    void vector (const std::vector<Type>& values) noexcept
+    {
+        numBytes += sizeof (uint32_t) + values.size() * sizeof (Type);
+    }
+
+    void check (bool) noexcept {}
+
+    size_t numBytes = 0;
+};
+
+template <typename Sink>
+class StateWriter
+{
+public:
+    explicit StateWriter (Sink& sinkToUse) noexcept : sink (sinkToUse) {}
+
+    static constexpr bool isRestoring() noexcept { return false; }
+    bool isValid() const noexcept                { return true; }
+
+    template <typename Type>
+    void value (const Type& v) noexcept
+    {
+        static_assert (std::is_trivially_copyable<Type>::value, "state is saved as raw bytes");
+        sink.write (&v, sizeof (Type));
+    }
+
+    template <typename Type>
+    void vector (const std::vector<Type>& values) noexcept
+    {
+        value (static_cast<uint32_t> (values.size()));
+
+        if (! values.empty())
+            sink.write (values.data(), values.size() * sizeof (Type));
+    }
+
+    void check (bool) noexcept {}
+
+private:
+    Sink& sink;
+};
+
+class StateReader
+{
+public:
+    StateReader (const void* sourceData, size_t sourceSize) noexcept
+        : data (static_cast<const char*> (sourceData)), size (sourceSize) {}
+
+    static constexpr bool isRestoring() noexcept { return true; }
+
+    //false once anything was missing or a check failed, nothing more is read after that
+    bool isValid() const noexcept { return ! failed; }
+
+    //every saved byte was read back and every check held
+    bool succeeded() const noexcept { return ! failed && position == size; }
+
+    template <typename Type>
+    void value (Type& v) noexcept
+    {
+        static_assert (std::is_trivially_copyable<Type>::value, "state is saved as raw bytes");
+        read (&v, sizeof (Type));
+    }
+
+    template <typename Type>
+    void vector (std::vector<Type>& values)
+    {
+        uint32_t numValues = 0;
+        value (numValues);
+
+        if (failed || position + numValues * sizeof (Type) > size)
+        {
+            failed = true;
+            return;
+        }
+
+        values.resize (numValues);
+
+        if (numValues > 0)
+            read (values.data(), numValues * sizeof (Type));
+    }
+
+    //the restoring object's own consistency checks, such as a matching channel count
+    void check (bool condition) noexcept { failed = failed || ! condition; }
+
+private:
+    void read (void* destination, size_t numBytes) noexcept
+    {
+        if (failed || position + numBytes > size)
+        {
+            failed = true;
+            return;
+        }
+
+        std::memcpy (destination, data + position, numBytes);
+        position += numBytes;
+    }
+
+    const char* data;
+    size_t size;
+    size_t position = 0;
+    bool failed = false;
+};
@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.cpp
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+
+TraceRecorder::TraceRecorder()
+    : juce::Thread ("trace writer")
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+}
+
+bool TraceRecorder::start (const juce::File& file, const Config& config, const juce::StringArray& parameterIds)
+{
+    stop();
+
+    //FileOutputStream appends to an existing file
+    file.deleteFile();
+    stream = std::make_unique<juce::FileOutputStream> (file);
+
+    if (! stream->openedOk())
+    {
+        stream.reset();
+        return false;
+    }
+
+    stream->writeInt (static_cast<int> (magic));
+    stream->writeInt (static_cast<int> (version));
+    stream->writeInt (parameterIds.size());
+
+    for (const auto& id : parameterIds)
+    {
+        const auto length = id.getNumBytesAsUTF8();
+        stream->writeInt (static_cast<int> (length));
+        stream->write (id.toRawUTF8(), length);
+    }
+
+    const auto bytesPerSecond = config.sampleRate * config.numChannels
+                              * (config.doublePrecision ? sizeof (double) : sizeof (float));
+    const int ringBytes = juce::jmax (minRingBytes, static_cast<int> (ringSeconds * bytesPerSecond));
+
+    ring.assign (static_cast<size_t> (ringBytes), 0);
+    fifo.setTotalSize (ringBytes);
+    fifo.reset();
+
+    pendingDropped.store (0);
+    totalDropped.store (0);
+    needsState.store (true);
+
+    //the audio thread isn't armed yet, so this is the only producer
+    writePrepareRecord (config);
+
+    startThread();
+    armed.store (true);
+    return true;
+}
+
+void TraceRecorder::stop()
+{
+    if (stream == nullptr)
+        return;
+
+    armed.store (false);
+
+    //a block that saw the capture armed finishes writing before the ring is drained
+    while (busy.load())
+        juce::Thread::yield();
+
+    stopThread (1000);
+    drain();
+
+    stream->flush();
+    stream.reset();
+}
+
+void TraceRecorder::capturePrepare (const Config& config)
+{
+    //prepareToPlay never overlaps processBlock, so this is still the single producer
+    if (armed.load())
+        writePrepareRecord (config);
+}
+
+void TraceRecorder::captureOrder (int order)
+{
+    //nor does building the ffts, the processor suspends processing for it
+    if (! armed.load())
+        return;
+
+    RingWriter writer (*this, recordSize (sizeof (int32_t)));
+
+    if (! writer.isValid())
+        return;
+
+    writeRecordHeader (writer, orderRecord, sizeof (int32_t));
+    writer.writeValue (static_cast<int32_t> (order));
+}
+
+void TraceRecorder::writePrepareRecord (const Config& config)
+{
+    RingWriter writer (*this, recordSize (preparePayload));
+
+    if (! writer.isValid())
+        return;
+
+    writeRecordHeader (writer, prepareRecord, preparePayload);
+    writer.writeValue (config.sampleRate);
+    writer.writeValue (static_cast<int32_t> (config.blockSize));
+    writer.writeValue (static_cast<int32_t> (config.numChannels));
+    writer.writeValue (static_cast<int32_t> (config.doublePrecision ? 1 : 0));
+    writer.writeValue (static_cast<int32_t> (config.analysisOrder));
+}
+
+void TraceRecorder::writeRecordHeader (RingWriter& writer, RecordType type, uint32_t payload)
+{
+    writer.writeValue (static_cast<uint32_t> (type));
+    writer.writeValue (payload);
+}
+
+void TraceRecorder::hashBytes (uint64_t& hash, const void* data, size_t numBytes) noexcept
+{
+    auto* bytes = static_cast<const unsigned char*> (data);
+
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+//==============================================================================
+void TraceRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        drain();
+        wait (drainIntervalMs);
+    }
+}
+
+void TraceRecorder::drain()
+{
+    const int numReady = fifo.getNumReady();
+
+    if (numReady == 0 || stream == nullptr)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+    stream->write (ring.data() + start1, static_cast<size_t> (size1));
+    if (size2 > 0)
+        stream->write (ring.data() + start2, static_cast<size_t> (size2));
+
+    fifo.finishedRead (size1 + size2);
+}
+
+//==============================================================================
+TraceRecorder::RingWriter::RingWriter (TraceRecorder& owner, int recordBytes)
+    : recorder (owner)
+{
+    const auto dropped = recorder.pendingDropped.load (std::memory_order_relaxed);
+    const int droppedBytes = dropped > 0 ? recordSize (sizeof (uint32_t)) : 0;
+
+    total = recordBytes + droppedBytes;
+
+    if (recorder.fifo.getFreeSpace() < total)
+    {
+        recorder.pendingDropped.store (dropped + 1, std::memory_order_relaxed);
+        recorder.totalDropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    recorder.fifo.prepareToWrite (total, start1, size1, start2, size2);
+    valid = true;
+
+    if (dropped > 0)
+    {
+        writeRecordHeader (*this, droppedRecord, sizeof (uint32_t));
+        writeValue (dropped);
+        recorder.pendingDropped.store (0, std::memory_order_relaxed);
+    }
+}
+
+TraceRecorder::RingWriter::~RingWriter()
+{
+    if (! valid)
+        return;
+
+    jassert (written == total);
+    recorder.fifo.finishedWrite (total);
+}
+
+void TraceRecorder::RingWriter::write (const void* data, size_t numBytes) noexcept
+{
+    auto* source = static_cast<const char*> (data);
+    auto remaining = static_cast<int> (numBytes);
+
+    //first region, then wrap into the second
+    if (written < size1)
+    {
+        const int n = juce::jmin (remaining, size1 - written);
+        std::memcpy (recorder.ring.data() + start1 + written, source, static_cast<size_t> (n));
+        written += n;
+        source += n;
+        remaining -= n;
+    }
+
+    if (remaining > 0)
+    {
+        const int offset = written - size1;
+        jassert (offset + remaining <= size2);
+        std::memcpy (recorder.ring.data() + start2 + offset, source, static_cast<size_t> (remaining));
+        written += remaining;
+    }
+}
@@ -0,0 +1,263 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+
+    Opt-in capture of exactly what the host feeds processBlock: every input
+    block, its size, the raw parameter values and the midi, so a reported
+    glitch can be replayed offline with TraceReplay. The audio thread only
+    copies the block into a lock-free byte ring; a background thread drains
+    the ring into the trace file. When the ring is full the block is dropped
+    and counted, the audio thread never waits on the writer.
+
+    Trace layout, host byte order:
+        magic, version, parameter count, then each parameter id as
+        (length, utf8 bytes), followed by records of (type, payload size,
+        payload):
+        prepare: sample rate (double), block size, channels, double precision,
+                 the engine's prepared fft order (from version 3)
+        block:   samples, channels, parameters, midi bytes, raw parameter
+                 values (float), midi events as (sample, size, bytes), then
+                 the input channels one after another in the prepared precision
+        output:  hashOutput() of the block once processed, right after its
+                 block record, missing when the ring had no room for it.
+                 Before version 4 the first block's hash leaves out its midi
+        dropped: number of blocks lost to a full ring just before this point
+        order:   the engine's ffts were built up to this order here, for a
+                 range below the prepared ones (from version 3)
+        state:   the engine's visitState image (see StateArchive.h), right
+                 before the first block record, so the replay starts from the
+                 state the capture did. Captures before version 4 reset the
+                 engine at their first block instead (from version 4)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StateArchive.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class TraceRecorder  : private juce::Thread
+{
+public:
+    static constexpr uint32_t magic = 0x52544153; //"SATR"
+    static constexpr uint32_t version = 4;
+
+    enum RecordType : uint32_t { prepareRecord = 1, blockRecord = 2, droppedRecord = 3, outputRecord = 4, orderRecord = 5, stateRecord = 6 };
+
+    //size of a prepare record's payload, older versions leave out the fft order
+    static constexpr uint32_t preparePayload = sizeof (double) + 4 * sizeof (int32_t);
+
+    struct Config
+    {
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        bool doublePrecision = false;
+        int analysisOrder = 0;
+    };
+
+    TraceRecorder();
+    ~TraceRecorder() override;
+
+    //message thread: opens the file, writes the header and arms the capture, the
+    //parameters are the processor's raw values in the order of parameterIds
+    bool start (const juce::File& file, const Config& config, const juce::StringArray& parameterIds);
+
+    //message thread: disarms, waits for the audio thread to leave the ring and
+    //flushes everything captured so far
+    void stop();
+
+    bool isCapturing() const noexcept { return armed.load(); }
+
+    //prepareToPlay while capturing, so the replay re-prepares at the same point
+    void capturePrepare (const Config& config);
+
+    //the engine built its ffts up to order while capturing, so the replay builds them
+    //before the same block. Only while processBlock can't run
+    void captureOrder (int order);
+
+    //audio thread, before the block is processed. The first block of a capture is
+    //preceded by the engine's state, saved through its visitState, so the replay can
+    //carry on from it while the live engine keeps running
+    template <typename SampleType, typename Engine>
+    void captureBlock (const juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midi,
+                       const std::atomic<float>* const* parameterValues, int numParameters, Engine& engine)
+    {
+        busy.store (true);
+
+        if (! armed.load())
+        {
+            busy.store (false);
+            return;
+        }
+
+        const int numSamples = buffer.getNumSamples();
+        const int numChannels = buffer.getNumChannels();
+
+        uint32_t midiBytes = 0;
+        for (const auto metadata : midi)
+            midiBytes += static_cast<uint32_t> (2 * sizeof (int32_t)) + static_cast<uint32_t> (metadata.numBytes);
+
+        const auto payload = static_cast<uint32_t> (4 * sizeof (int32_t) + numParameters * sizeof (float) + midiBytes
+                                                    + static_cast<size_t> (numChannels) * static_cast<size_t> (numSamples) * sizeof (SampleType));
+
+        //the capture only starts with a block that fits in the ring along with the
+        //state, blocks before it aren't dropped, they just aren't part of it yet
+        const bool startsCapture = needsState.load();
+        uint32_t statePayload = 0;
+
+        if (startsCapture)
+        {
+            StateSizer sizer;
+            engine.visitState (sizer);
+            statePayload = static_cast<uint32_t> (sizer.numBytes);
+
+            if (fifo.getFreeSpace() < recordSize (statePayload) + recordSize (payload))
+            {
+                busy.store (false);
+                return;
+            }
+        }
+
+        RingWriter writer (*this, (startsCapture ? recordSize (statePayload) : 0) + recordSize (payload));
+
+        if (writer.isValid())
+        {
+            if (startsCapture)
+            {
+                writeRecordHeader (writer, stateRecord, statePayload);
+                StateWriter<RingWriter> stateWriter (writer);
+                engine.visitState (stateWriter);
+                needsState.store (false);
+            }
+
+            writeRecordHeader (writer, blockRecord, payload);
+            writer.writeValue (static_cast<int32_t> (numSamples));
+            writer.writeValue (static_cast<int32_t> (numChannels));
+            writer.writeValue (static_cast<int32_t> (numParameters));
+            writer.writeValue (static_cast<int32_t> (midiBytes));
+
+            for (int p = 0; p < numParameters; ++p)
+                writer.writeValue (parameterValues[p]->load());
+
+            for (const auto metadata : midi)
+            {
+                writer.writeValue (static_cast<int32_t> (metadata.samplePosition));
+                writer.writeValue (static_cast<int32_t> (metadata.numBytes));
+                writer.write (metadata.data, static_cast<size_t> (metadata.numBytes));
+            }
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                writer.write (buffer.getReadPointer (channel), static_cast<size_t> (numSamples) * sizeof (SampleType));
+        }
+
+        blockCaptured = writer.isValid();
+        busy.store (false);
+    }
+
+    //audio thread, after the block is processed: records the hash of its output so a
+    //replay can check it reproduces the capture bit for bit. Skipped when the ring is
+    //full, that block just goes unchecked
+    template <typename SampleType>
+    void captureOutput (const juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midi)
+    {
+        busy.store (true);
+
+        if (armed.load() && blockCaptured && fifo.getFreeSpace() >= recordSize (sizeof (uint64_t)))
+        {
+            RingWriter writer (*this, recordSize (sizeof (uint64_t)));
+            writeRecordHeader (writer, outputRecord, sizeof (uint64_t));
+            writer.writeValue (hashOutput (buffer, midi, true));
+        }
+
+        blockCaptured = false;
+        busy.store (false);
+    }
+
+    //FNV-1a of every output channel of a block and, with includeMidi, its midi events.
+    //Captures always include it, a replay of an older one leaves it out where it did
+    template <typename SampleType>
+    static uint64_t hashOutput (const juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midi, bool includeMidi) noexcept
+    {
+        uint64_t hash = hashOffset;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            hashBytes (hash, buffer.getReadPointer (channel), static_cast<size_t> (buffer.getNumSamples()) * sizeof (SampleType));
+
+        if (! includeMidi)
+            return hash;
+
+        for (const auto metadata : midi)
+        {
+            const auto samplePosition = static_cast<int32_t> (metadata.samplePosition);
+            hashBytes (hash, &samplePosition, sizeof (samplePosition));
+            hashBytes (hash, metadata.data, static_cast<size_t> (metadata.numBytes));
+        }
+
+        return hash;
+    }
+
+    static constexpr uint64_t hashOffset = 14695981039346656037ull;
+    static void hashBytes (uint64_t& hash, const void* data, size_t numBytes) noexcept;
+
+    //blocks lost to a full ring since the capture started
+    uint32_t getNumDroppedBlocks() const noexcept { return totalDropped.load (std::memory_order_relaxed); }
+
+private:
+    //claims room for one record, prefixed by a dropped record when blocks were
+    //lost, and publishes it to the writer thread when it goes out of scope
+    class RingWriter
+    {
+    public:
+        RingWriter (TraceRecorder& owner, int recordBytes);
+        ~RingWriter();
+
+        bool isValid() const noexcept { return valid; }
+
+        void write (const void* data, size_t numBytes) noexcept;
+
+        template <typename Type>
+        void writeValue (Type value) noexcept  { write (&value, sizeof (Type)); }
+
+    private:
+        TraceRecorder& recorder;
+        int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+        int written = 0;
+        int total = 0;
+        bool valid = false;
+    };
+
+    static int recordSize (uint32_t payload) { return static_cast<int> (2 * sizeof (uint32_t) + payload); }
+    static void writeRecordHeader (RingWriter& writer, RecordType type, uint32_t payload);
+    void writePrepareRecord (const Config& config);
+
+
+    void run() override;
+    void drain();
+
+    juce::AbstractFifo fifo { 1 };
+    std::vector<char> ring;
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    std::atomic<bool> armed { false };
+    std::atomic<bool> busy { false };
+    std::atomic<bool> needsState { false };
+    std::atomic<uint32_t> pendingDropped { 0 };
+    std::atomic<uint32_t> totalDropped { 0 };
+
+    //audio thread only, whether the current block's record made it into the ring
+    bool blockCaptured = false;
+
+    //the ring holds at least this many seconds of audio
+    static constexpr double ringSeconds = 2.0;
+    static constexpr int minRingBytes = 1 << 20;
+    static constexpr int drainIntervalMs = 5;
+
+    JUCE_DECLARE_NON_COPYABLE (TraceRecorder)
+};